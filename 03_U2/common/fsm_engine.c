@@ -0,0 +1,153 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module fsm_engine.
+ * --
+ * -- $Id: fsm_engine.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <stddef.h>
+
+/* user includes */
+#include "fsm_engine.h"
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+static uint8_t parent_of(const fe_machine_t *m, uint8_t state)
+{
+    return (state == FE_TOP) ? FE_TOP : m->states[state].parent;
+}
+
+/*
+ * Returns 1 if a is a parent, grandparent, ... of state.
+ */
+static uint8_t contains(const fe_machine_t *m, uint8_t a, uint8_t state)
+{
+    if (a == FE_TOP) {
+        return 1u;
+    }
+    for (state = parent_of(m, state); state != FE_TOP; state = parent_of(m, state)) {
+        if (state == a) {
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+/*
+ * Enters the states below top down to target.
+ */
+static void enter(const fe_machine_t *m, uint8_t top, uint8_t target)
+{
+    uint8_t state;
+
+    while (top != target) {
+        /* Child of top on the way to target */
+        state = target;
+        while (parent_of(m, state) != top) {
+            state = parent_of(m, state);
+        }
+        if (m->states[state].entry != NULL) {
+            m->states[state].entry();
+        }
+        top = state;
+    }
+}
+
+static const fe_transition_t *find(const fe_machine_t *m, uint8_t *source,
+                                   uint8_t event)
+{
+    const fe_transition_t *t;
+    uint8_t state;
+
+    for (state = *source; state != FE_TOP; state = parent_of(m, state)) {
+        t = &m->table[state * m->nr_of_events + event];
+        if (t->used && (t->guard == NULL || t->guard())) {
+            *source = state;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void fe_start(fe_t *fsm, const fe_machine_t *machine, uint8_t initial)
+{
+    fsm->machine = machine;
+    fsm->state = initial;
+    enter(machine, FE_TOP, initial);
+}
+
+
+/*
+ * See header file
+ */
+uint8_t fe_dispatch(fe_t *fsm, uint8_t event)
+{
+    const fe_machine_t *m = fsm->machine;
+    const fe_transition_t *t;
+    uint8_t source = fsm->state;
+    uint8_t common = FE_TOP;
+    uint8_t state;
+    uint8_t i;
+
+    if (event >= m->nr_of_events) {
+        return 0u;
+    }
+    t = find(m, &source, event);
+    if (t == NULL) {
+        return 0u;
+    }
+
+    if (t->next != FE_INTERNAL) {
+        /* Lowest state around both source and target. For a transition
+         * of a state to itself that is its parent, so it is left and
+         * entered again. */
+        common = source;
+        while (!contains(m, common, t->next)) {
+            common = parent_of(m, common);
+        }
+        for (state = fsm->state; state != common; state = parent_of(m, state)) {
+            if (m->states[state].exit != NULL) {
+                m->states[state].exit();
+            }
+        }
+    }
+
+    for (i = 0u; i < FE_ACTIONS; i++) {
+        if (t->action[i] != NULL) {
+            t->action[i]();
+        }
+    }
+
+    if (t->next != FE_INTERNAL) {
+        enter(m, common, t->next);
+        fsm->state = t->next;
+    }
+    return 1u;
+}
+
+
+/*
+ * See header file
+ */
+uint8_t fe_state(const fe_t *fsm)
+{
+    return fsm->state;
+}
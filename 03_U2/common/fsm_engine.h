@@ -0,0 +1,103 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Interface of module fsm_engine.
+ * --
+ * -- Runs a state machine that is given as constant tables:
+ * --
+ * --   states      entry action, exit action and parent of each state
+ * --   transitions state x event -> guard, actions, next state
+ * --
+ * -- The transition of an event is looked up by index. If the state has
+ * -- none, or its guard is false, the parent state is tried next. States
+ * -- with children only group transitions. They are never the current
+ * -- state and cannot be the target of a transition.
+ * --
+ * -- An external transition exits the states up to the common parent of
+ * -- source and target, runs the transition actions and enters the states
+ * -- down to the target.
+ * --
+ * -- $Id: fsm_engine.h $
+ * ------------------------------------------------------------------------- */
+
+/* re-definition guard */
+#ifndef _FSM_ENGINE_H
+#define _FSM_ENGINE_H
+
+/* standard includes */
+#include <stdint.h>
+#include <stddef.h>
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define FE_TOP          (0xffu)     // parent of the top level states
+#define FE_INTERNAL     (0xfeu)     // next state: run actions, stay
+#define FE_ACTIONS      2u          // actions per transition
+
+/*
+ * Table entries. Pass NULL for an unused action.
+ */
+#define FE_GOTO(next)                   { 1u, (next), NULL, { NULL } }
+#define FE_GOTO_DO(next, ...)           { 1u, (next), NULL, { __VA_ARGS__ } }
+#define FE_GOTO_IF(guard, next, ...)    { 1u, (next), (guard), { __VA_ARGS__ } }
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+typedef void (*fe_action_t)(void);
+typedef uint8_t (*fe_guard_t)(void);
+
+typedef struct {
+    fe_action_t entry;              // NULL if none
+    fe_action_t exit;               // NULL if none
+    uint8_t parent;                 // FE_TOP on the top level
+} fe_state_t;
+
+typedef struct {
+    uint8_t used;                   // 0 for an empty table entry
+    uint8_t next;                   // target state or FE_INTERNAL
+    fe_guard_t guard;               // NULL if none
+    fe_action_t action[FE_ACTIONS];
+} fe_transition_t;
+
+typedef struct {
+    const fe_state_t *states;       // [nr_of_states]
+    const fe_transition_t *table;   // [nr_of_states][nr_of_events]
+    uint8_t nr_of_states;
+    uint8_t nr_of_events;
+} fe_machine_t;
+
+typedef struct {
+    const fe_machine_t *machine;
+    uint8_t state;
+} fe_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Enters the initial state, parents first.
+ */
+void fe_start(fe_t *fsm, const fe_machine_t *machine, uint8_t initial);
+
+/*
+ * Runs the transition of the event from the current state.
+ * Returns 1 if a transition was taken, 0 if the event was ignored.
+ */
+uint8_t fe_dispatch(fe_t *fsm, uint8_t event);
+
+/*
+ * Returns the current state.
+ */
+uint8_t fe_state(const fe_t *fsm);
+#endif
@@ -36,7 +36,8 @@ typedef enum {
     BUTTON_STOP,
     FLOATER_HIGH,
     FLOATER_LOW,
-    TEMPERATURE_HOT
+    TEMPERATURE_HOT,
+    NR_OF_EVENTS
 } event_t;
 
 
@@ -9,16 +9,23 @@
  * --
  * -- Description:  Implementation of module state_machine.
  * --
+ * -- The washing machine as tables for fsm_engine. RUNNING groups the
+ * -- states of a wash cycle, BUTTON_STOP leads from all of them to
+ * -- SHUT_DOWN. Each state switches on what it needs in its entry action
+ * -- and switches it off again in its exit action.
+ * --
  * -- $Id: state_machine.c 5605 2023-01-05 15:52:42Z frtt $
  * ------------------------------------------------------------------------- */
 
 /* standard includes */
 #include <stdint.h>
+#include <stddef.h>
 #include <reg_stm32f4xx.h>
 
 /* user includes */
 #include "state_machine.h"
 #include "action_handler.h"
+#include "fsm_engine.h"
 #include "timer.h"
 
 
@@ -46,10 +53,138 @@
 /* Local variables
  * ------------------------------------------------------------------------- */
 
-static state_t state = DOOR_OPEN;
+static fe_t fsm;
 static uint8_t floater_position = LOW;
 
 
+/* Guards and actions
+ * ------------------------------------------------------------------------- */
+
+static uint8_t floater_high(void)
+{
+    return floater_position == HIGH;
+}
+
+static uint8_t floater_low(void)
+{
+    return floater_position == LOW;
+}
+
+static void enter_door_open(void)
+{
+    ah_lcd_write(TEXT_DOOR_OPEN);
+}
+
+static void enter_idle(void)
+{
+    ah_lcd_write(TEXT_IDLE);
+}
+
+static void enter_fill_water(void)
+{
+    ah_open_valve();
+    ah_lcd_write(TEXT_FILL_WATER);
+}
+
+static void enter_heat_water(void)
+{
+    ah_heater_on();
+    ah_lcd_write(TEXT_HEAT_WATER);
+}
+
+static void enter_rotate_right(void)
+{
+    timer_start(TIMER_DURATION_RIGHT);
+    ah_motor_on(RIGHT, SLOW);
+    ah_lcd_write(TEXT_ROTATE_RIGHT);
+}
+
+static void enter_rotate_left(void)
+{
+    ah_motor_on(LEFT, SLOW);
+    timer_start(TIMER_DURATION_LEFT);
+    ah_lcd_write(TEXT_ROTATE_LEFT);
+}
+
+static void enter_empty_water(void)
+{
+    ah_pump_on();
+    ah_lcd_write(TEXT_EMPTY_WATER);
+}
+
+static void enter_spin_dry(void)
+{
+    timer_start(TIMER_DURATION_SPIN);
+    ah_motor_on(LEFT, FAST);
+    ah_lcd_write(TEXT_SPIN_DRY);
+}
+
+static void enter_shut_down(void)
+{
+    ah_close_valve();
+    ah_pump_on();
+    ah_lcd_write(TEXT_SHUT_DOWN);
+}
+
+
+/* State machine tables
+ * ------------------------------------------------------------------------- */
+
+static const fe_state_t states[NR_OF_STATES] = {
+    [DOOR_OPEN]    = { enter_door_open,    NULL,           FE_TOP  },
+    [IDLE]         = { enter_idle,         NULL,           FE_TOP  },
+    [FILL_WATER]   = { enter_fill_water,   ah_close_valve, RUNNING },
+    [HEAT_WATER]   = { enter_heat_water,   ah_heater_off,  RUNNING },
+    [ROTATE_RIGHT] = { enter_rotate_right, ah_motor_off,   RUNNING },
+    [ROTATE_LEFT]  = { enter_rotate_left,  ah_motor_off,   RUNNING },
+    [EMPTY_WATER]  = { enter_empty_water,  NULL,           RUNNING },
+    [SPIN_DRY]     = { enter_spin_dry,     ah_motor_off,   RUNNING },
+    [SHUT_DOWN]    = { enter_shut_down,    NULL,           FE_TOP  },
+    [RUNNING]      = { NULL,               NULL,           FE_TOP  }
+};
+
+static const fe_transition_t transitions[NR_OF_STATES][NR_OF_EVENTS] = {
+    [DOOR_OPEN] = {
+        [DOOR_CLOSED]     = FE_GOTO(IDLE)
+    },
+    [IDLE] = {
+        [DOOR_OPENED]     = FE_GOTO(DOOR_OPEN),
+        [BUTTON_WASH]     = FE_GOTO_DO(FILL_WATER, ah_lock_door),
+        [BUTTON_SPIN]     = FE_GOTO(EMPTY_WATER)
+    },
+    [FILL_WATER] = {
+        [FLOATER_HIGH]    = FE_GOTO_IF(floater_high, HEAT_WATER, NULL),
+        [BUTTON_SPIN]     = FE_GOTO(EMPTY_WATER)
+    },
+    [HEAT_WATER] = {
+        [TEMPERATURE_HOT] = FE_GOTO(ROTATE_RIGHT),
+        [BUTTON_SPIN]     = FE_GOTO(EMPTY_WATER)
+    },
+    [ROTATE_RIGHT] = {
+        [TIME_OUT]        = FE_GOTO(ROTATE_LEFT)
+    },
+    [ROTATE_LEFT] = {
+        [TIME_OUT]        = FE_GOTO(EMPTY_WATER)
+    },
+    [EMPTY_WATER] = {
+        [FLOATER_LOW]     = FE_GOTO_IF(floater_low, SPIN_DRY, ah_pump_off)
+    },
+    [SPIN_DRY] = {
+        [TIME_OUT]        = FE_GOTO(SHUT_DOWN)
+    },
+    [SHUT_DOWN] = {
+        [FLOATER_LOW]     = FE_GOTO_IF(floater_low, IDLE, ah_pump_off, ah_unlock_door)
+    },
+    [RUNNING] = {
+        [BUTTON_STOP]     = FE_GOTO(SHUT_DOWN)
+    }
+};
+
+static const fe_machine_t machine = {
+    &states[0], &transitions[0][0], NR_OF_STATES, NR_OF_EVENTS
+};
+
+
 /* Public function definitions
  * ------------------------------------------------------------------------- */
 
@@ -67,8 +202,7 @@ void fsm_init(void)
     ah_pump_off();
     ah_unlock_door();
 
-    ah_lcd_write(TEXT_DOOR_OPEN);
-    state = DOOR_OPEN;
+    fe_start(&fsm, &machine, DOOR_OPEN);
 }
 
 
@@ -77,8 +211,6 @@ void fsm_init(void)
  */
 void fsm_handle_event(event_t event)
 {
-    // State machine implementation according to your model from last week's exercise.
-
     // Track floater position across all events
     if (event == FLOATER_HIGH) {
         floater_position = HIGH;
@@ -87,184 +219,5 @@ void fsm_handle_event(event_t event)
         floater_position = LOW;
     }
 
-    // State machine logic
-    switch (state) {
-        case DOOR_OPEN:
-            if (event == DOOR_CLOSED) {
-                ah_lcd_write(TEXT_IDLE);
-                state = IDLE;
-            }
-            break;
-
-        case IDLE:
-            switch (event) {
-                case DOOR_OPENED:
-                    ah_lcd_write(TEXT_DOOR_OPEN);
-                    state = DOOR_OPEN;
-                    break;
-                case BUTTON_WASH:
-                    ah_lock_door();
-                    ah_open_valve();
-                    ah_lcd_write(TEXT_FILL_WATER);
-                    state = FILL_WATER;
-                    break;
-                case BUTTON_SPIN:
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_EMPTY_WATER);
-                    state = EMPTY_WATER;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case FILL_WATER:
-            switch (event) {
-                case FLOATER_HIGH:
-                    if (floater_position == HIGH) {
-                        ah_close_valve();
-                        ah_heater_on();
-                        ah_lcd_write(TEXT_HEAT_WATER);
-                        state = HEAT_WATER;
-                    }
-                    break;
-                case BUTTON_STOP:
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                case BUTTON_SPIN:
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_EMPTY_WATER);
-                    state = EMPTY_WATER;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case HEAT_WATER:
-            switch (event) {
-                case TEMPERATURE_HOT:
-                    ah_heater_off();
-                    timer_start(TIMER_DURATION_RIGHT);
-                    ah_motor_on(RIGHT, SLOW);
-                    ah_lcd_write(TEXT_ROTATE_RIGHT);
-                    state = ROTATE_RIGHT;
-                    break;
-                case BUTTON_SPIN:
-                    ah_heater_off();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_EMPTY_WATER);
-                    state = EMPTY_WATER;
-                    break;
-                case BUTTON_STOP:
-                    ah_heater_off();
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case ROTATE_RIGHT:
-            switch (event) {
-                case TIME_OUT:
-                    ah_motor_off();
-                    ah_motor_on(LEFT, SLOW);
-                    timer_start(TIMER_DURATION_LEFT);
-                    ah_lcd_write(TEXT_ROTATE_LEFT);
-                    state = ROTATE_LEFT;
-                    break;
-                case BUTTON_STOP:
-                    ah_motor_off();
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case ROTATE_LEFT:
-            switch (event) {
-                case TIME_OUT:
-                    ah_motor_off();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_EMPTY_WATER);
-                    state = EMPTY_WATER;
-                    break;
-                case BUTTON_STOP:
-                    ah_motor_off();
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case EMPTY_WATER:
-            switch (event) {
-                case FLOATER_LOW:
-                    if (floater_position == LOW) {
-                        ah_pump_off();
-                        timer_start(TIMER_DURATION_SPIN);
-                        ah_motor_on(LEFT, FAST);
-                        ah_lcd_write(TEXT_SPIN_DRY);
-                        state = SPIN_DRY;
-                    }
-                    break;
-                case BUTTON_STOP:
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case SPIN_DRY:
-            switch (event) {
-                case TIME_OUT:
-                    ah_motor_off();
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                case BUTTON_STOP:
-                    ah_motor_off();
-                    ah_close_valve();
-                    ah_pump_on();
-                    ah_lcd_write(TEXT_SHUT_DOWN);
-                    state = SHUT_DOWN;
-                    break;
-                default:
-                    break;
-            }
-            break;
-
-        case SHUT_DOWN:
-            if (event == FLOATER_LOW) {
-                if (floater_position == LOW) {
-                    ah_pump_off();
-                    ah_unlock_door();
-                    ah_lcd_write(TEXT_IDLE);
-                    state = IDLE;
-                }
-            }
-            break;
-    }
+    fe_dispatch(&fsm, (uint8_t)event);
 }
@@ -19,6 +19,7 @@
 
 /* user includes */
 #include "event_handler.h"
+#include "event_queue.h"
 #include "timer.h"
 
 
@@ -40,24 +41,29 @@
 #define MASK_THERMOSTAT       (0x20)
 #define MASK_CLEAR_INPUT      (0x3F)
 
-/* Public function definitions
+#define SAMPLE_PERIOD         1u          // clocks of 100 Hz --> 10 ms
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static uint8_t port_value_old = 0xff;
+
+
+/* Local function definitions
  * ------------------------------------------------------------------------- */
 
 /*
- * See header file
+ * Samples the inport and puts an event for each edge into the event queue.
+ * Runs in the timer interrupt.
  */
-event_t eh_get_event(void)
+static void sample_inputs(void)
 {
-    event_t event = NO_EVENT;
-
-    static uint8_t port_value_old = 0xff;
     uint8_t port_value;
     uint8_t port_value_control;
     uint8_t edge_positive = 0;
     uint8_t edge_negative = 0;
 
-    uint16_t timer;
-
     /* Read the input port */
     port_value = PORT_INPUT & MASK_CLEAR_INPUT;
     port_value_control = PORT_INPUT & MASK_CLEAR_INPUT;
@@ -70,45 +76,60 @@ event_t eh_get_event(void)
         port_value_old = port_value;
     }
 
-    /* Get the current timer value */
-    timer = timer_read();
-
     /// Add here the events that will be needed for your washing machine
 
-    // Check button events (positive edge = DIP switch turned ON)
+    /* Post every edge of this sample, in order of priority. Edges that
+     * come together (door and floater) all reach the state machine. */
+
+    // Button events (positive edge = DIP switch turned ON)
     if (edge_positive & MASK_BUTTON_STOP) {
-        event = BUTTON_STOP;
-    }
-    else if (edge_positive & MASK_BUTTON_WASH) {
-        event = BUTTON_WASH;
+        eq_put(BUTTON_STOP);
     }
-    else if (edge_positive & MASK_BUTTON_SPIN) {
-        event = BUTTON_SPIN;
+    if (edge_positive & MASK_BUTTON_WASH) {
+        eq_put(BUTTON_WASH);
     }
-    // Check door events (single bit: positive edge = opened, negative edge = closed)
-    else if (edge_positive & MASK_DOOR) {
-        event = DOOR_OPENED;
+    if (edge_positive & MASK_BUTTON_SPIN) {
+        eq_put(BUTTON_SPIN);
     }
-    else if (edge_negative & MASK_DOOR) {
-        event = DOOR_CLOSED;
+    // Door events (single bit: positive edge = opened, negative edge = closed)
+    if (edge_positive & MASK_DOOR) {
+        eq_put(DOOR_OPENED);
     }
-    // Check floater events (single bit: positive edge = high, negative edge = low)
-    else if (edge_positive & MASK_FLOATER) {
-        event = FLOATER_HIGH;
+    if (edge_negative & MASK_DOOR) {
+        eq_put(DOOR_CLOSED);
     }
-    else if (edge_negative & MASK_FLOATER) {
-        event = FLOATER_LOW;
+    // Floater events (single bit: positive edge = high, negative edge = low)
+    if (edge_positive & MASK_FLOATER) {
+        eq_put(FLOATER_HIGH);
     }
-    // Check thermostat event (positive edge = hot)
-    else if (edge_positive & MASK_THERMOSTAT) {
-        event = TEMPERATURE_HOT;
+    if (edge_negative & MASK_FLOATER) {
+        eq_put(FLOATER_LOW);
     }
-    // Check timer timeout
-    else if (timer == 0) {
-        event = TIME_OUT;
+    // Thermostat event (positive edge = hot)
+    if (edge_positive & MASK_THERMOSTAT) {
+        eq_put(TEMPERATURE_HOT);
     }
 
     /// END: To be programmed
+}
+
 
-    return event;
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void eh_init(void)
+{
+    timer_start_call(TIMER_INPUTS, SAMPLE_PERIOD, SAMPLE_PERIOD, sample_inputs);
+}
+
+
+/*
+ * See header file
+ */
+event_t eh_get_event(void)
+{
+    return eq_get();
 }
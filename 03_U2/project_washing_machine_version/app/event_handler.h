@@ -9,7 +9,8 @@
  * --
  * -- Description:  Interface of module event_handler.
  * --
- * -- Generates events based on rising or falling edges on inport.
+ * -- Generates events based on rising or falling edges on inport and
+ * -- passes them through the event queue.
  * --
  * -- $Id: event_handler.h 1991 2015-04-29 04:43:29Z ruan $
  * ------------------------------------------------------------------------- */
@@ -36,7 +37,8 @@ typedef enum {
     BUTTON_STOP,
     FLOATER_HIGH,
     FLOATER_LOW,
-    TEMPERATURE_HOT
+    TEMPERATURE_HOT,
+    NR_OF_EVENTS
 } event_t;
 
 
@@ -44,7 +46,14 @@ typedef enum {
  * ------------------------------------------------------------------------- */
 
 /*
- * Check inport and timer and generate event
+ * Starts sampling the inport every 10 ms. Each edge puts an event into
+ * the event queue. Call after timer_init().
+ */
+void eh_init(void);
+
+
+/*
+ * Returns the oldest queued event, NO_EVENT if there is none.
  */
 event_t eh_get_event(void);
 #endif
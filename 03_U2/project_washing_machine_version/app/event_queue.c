@@ -0,0 +1,115 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module event_queue.
+ * --
+ * -- head and tail run freely and wrap at 256, the slot is the index
+ * -- masked with EQ_SIZE - 1. The queue is empty if head == tail and full
+ * -- if head - tail == EQ_SIZE. Single byte stores are atomic on the
+ * -- Cortex-M, so neither side has to disable interrupts.
+ * --
+ * -- $Id: event_queue.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+
+/* user includes */
+#include "event_queue.h"
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define EQ_MASK     (EQ_SIZE - 1u)
+
+#if (EQ_SIZE & EQ_MASK) != 0u || EQ_SIZE > 128u
+#error "EQ_SIZE must be a power of 2, at most 128"
+#endif
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static volatile uint8_t ring[EQ_SIZE];
+static volatile uint8_t head = 0u;      // next slot to write, producer only
+static volatile uint8_t tail = 0u;      // next slot to read, consumer only
+static volatile uint16_t overflows = 0u;
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+uint8_t eq_put(event_t event)
+{
+    uint8_t h = head;
+
+    if ((uint8_t)(h - tail) >= EQ_SIZE) {
+        overflows++;
+        return 0u;
+    }
+    ring[h & EQ_MASK] = (uint8_t)event;
+
+    /* Publish the slot only after it is written */
+    __asm volatile ("dmb" ::: "memory");
+    head = (uint8_t)(h + 1u);
+
+    return 1u;
+}
+
+
+/*
+ * See header file
+ */
+event_t eq_get(void)
+{
+    uint8_t t = tail;
+    event_t event;
+
+    if (t == head) {
+        return NO_EVENT;
+    }
+    event = (event_t)ring[t & EQ_MASK];
+
+    /* Release the slot only after it is read */
+    __asm volatile ("dmb" ::: "memory");
+    tail = (uint8_t)(t + 1u);
+
+    return event;
+}
+
+
+/*
+ * See header file
+ */
+void eq_wait(void)
+{
+    /* With interrupts masked, a pending interrupt still ends WFI. An event
+     * put between the check and WFI is therefore not slept over. */
+    __asm volatile ("cpsid i");
+    while (tail == head) {
+        __asm volatile ("wfi");
+        __asm volatile ("cpsie i");
+        __asm volatile ("isb");
+        __asm volatile ("cpsid i");
+    }
+    __asm volatile ("cpsie i");
+}
+
+
+/*
+ * See header file
+ */
+uint16_t eq_overflows(void)
+{
+    return overflows;
+}
@@ -0,0 +1,60 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Interface of module event_queue.
+ * --
+ * -- Ring buffer of events between one interrupt (producer) and the main
+ * -- loop (consumer). Lock-free: head is only written by the producer,
+ * -- tail only by the consumer.
+ * --
+ * -- $Id: event_queue.h $
+ * ------------------------------------------------------------------------- */
+
+/* re-definition guard */
+#ifndef _EVENT_QUEUE_H
+#define _EVENT_QUEUE_H
+
+/* standard includes */
+#include <stdint.h>
+
+/* user includes */
+#include "event_handler.h"
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define EQ_SIZE     16u                 // power of 2, at most 128
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Appends an event. Producer side, call from one interrupt only.
+ * Returns 0 if the queue is full and the event was dropped, 1 otherwise.
+ */
+uint8_t eq_put(event_t event);
+
+/*
+ * Removes the oldest event. Consumer side, call from main only.
+ * Returns NO_EVENT if the queue is empty.
+ */
+event_t eq_get(void);
+
+/*
+ * Sleeps with WFI until the queue holds at least one event.
+ */
+void eq_wait(void);
+
+/*
+ * Number of events dropped because the queue was full.
+ */
+uint16_t eq_overflows(void);
+#endif
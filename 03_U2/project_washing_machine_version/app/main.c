@@ -27,6 +27,7 @@
 
 /* user includes */
 #include "event_handler.h"
+#include "event_queue.h"
 #include "state_machine.h"
 #include "timer.h"
 
@@ -44,15 +45,24 @@
 
 int main(void)
 {
+    event_t event;
+
     /// STUDENTS: To be programmed
 
-    // Initialize state machine and timer
-    fsm_init();
+    // Initialize timer, state machine and input sampling
     timer_init();
+    fsm_init();
+    eh_init();
 
-    // Main event loop
+    // Main event loop: handle all queued events, then sleep until the
+    // timer interrupt queues the next ones
     while (1) {
-        fsm_handle_event(eh_get_event());
+        eq_wait();
+        event = eh_get_event();
+        while (event != NO_EVENT) {
+            fsm_handle_event(event);
+            event = eh_get_event();
+        }
     }
 
     /// END: To be programmed
@@ -38,7 +38,9 @@ typedef enum {
     ROTATE_LEFT,
     EMPTY_WATER,
     SPIN_DRY,
-    SHUT_DOWN
+    SHUT_DOWN,
+    RUNNING,                // groups the states of a wash cycle
+    NR_OF_STATES
 } state_t;
 
 
@@ -9,14 +9,27 @@
  * --
  * -- Description:  Implementation of module timer.
  * --
+ * -- TIM4 counts freely at 10 kHz. The remaining time of each channel is
+ * -- kept relative to the counter value 'last'. The interrupt subtracts the
+ * -- time since then from all channels, serves the ones that ran down and
+ * -- sets compare channel 1 to the nearest remaining deadline. The distance
+ * -- is limited to half the counter range, so the time since 'last' stays
+ * -- unambiguous while a channel runs.
+ * --
+ * -- There are only a few channels, a linear search is faster than a heap
+ * -- or a timer wheel at this size.
+ * --
  * -- $Id: timer.c 2690 2015-11-18 15:37:30Z fert $
  * ------------------------------------------------------------------------- */
 
 /* standard includes */
 #include <stdint.h>
+#include <stddef.h>
 
 /* user includes */
 #include "timer.h"
+#include "event_handler.h"
+#include "event_queue.h"
 #include "hal_timer.h"
 #include "hal_rcc.h"
 
@@ -24,12 +37,156 @@
 /* function prototype
  * ------------------------------------------------------------------------- */
 void TIM4_IRQHandler(void);
- 
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define COUNTS_PER_CLOCK    100u                // 10 kHz / 100 Hz
+#define MAX_WAIT            0x8000u             // half the 16 bit counter
+#define EGR_CC1G            (0x1u << 1u)        // software compare event
+
+
+/* Type definitions
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t remaining;                 // counts after 'last'
+    uint32_t period;                    // counts, 0 for one-shot
+    event_t event;
+    timer_handler_t handler;            // NULL: queue event
+    uint8_t running;
+} channel_t;
+
 
 /* Local variables
  * ------------------------------------------------------------------------- */
 
-static uint16_t timer_count = 0u;
+static channel_t channels[TIMER_CHANNELS];
+static uint16_t last = 0u;
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+static uint32_t irq_lock(void)
+{
+    uint32_t primask;
+
+    __asm volatile ("mrs %0, primask" : "=r" (primask));
+    __asm volatile ("cpsid i" ::: "memory");
+    return primask;
+}
+
+static void irq_unlock(uint32_t primask)
+{
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+static uint16_t since_last(void)
+{
+    return (uint16_t)(hal_timer_counter_read(TIM4) - last);
+}
+
+/*
+ * Subtracts the time since 'last' and serves the channels that ran down.
+ * Called from the interrupt only.
+ */
+static void advance(void)
+{
+    uint16_t elapsed = since_last();
+    channel_t *c;
+    uint32_t late;
+    uint8_t i;
+
+    last = (uint16_t)(last + elapsed);
+
+    for (i = 0u; i < TIMER_CHANNELS; i++) {
+        c = &channels[i];
+        if (!c->running) {
+            continue;
+        }
+        if (c->remaining > elapsed) {
+            c->remaining -= elapsed;
+            continue;
+        }
+
+        /* Keep the period from drifting by the interrupt latency */
+        late = elapsed - c->remaining;
+        if (c->period == 0u) {
+            c->running = 0u;
+        } else {
+            c->remaining = (c->period > late) ? c->period - late : 0u;
+        }
+
+        if (c->handler != NULL) {
+            c->handler();
+        } else {
+            eq_put(c->event);
+        }
+    }
+}
+
+/*
+ * Sets the compare value to the nearest deadline, or turns the interrupt
+ * off if no channel runs. Called with the interrupt locked.
+ */
+static void schedule(void)
+{
+    uint32_t next = MAX_WAIT;
+    uint8_t running = 0u;
+    uint8_t i;
+
+    for (i = 0u; i < TIMER_CHANNELS; i++) {
+        if (channels[i].running) {
+            running = 1u;
+            if (channels[i].remaining < next) {
+                next = channels[i].remaining;
+            }
+        }
+    }
+
+    if (!running) {
+        hal_timer_irq_set(TIM4, HAL_TIMER_IRQ_CC1, DISABLED);
+        return;
+    }
+
+    hal_timer_compare_write(TIM4, HAL_TIMER_CH1, (uint16_t)(last + next));
+    hal_timer_irq_clear(TIM4, HAL_TIMER_IRQ_CC1);
+    hal_timer_irq_set(TIM4, HAL_TIMER_IRQ_CC1, ENABLED);
+
+    /* The counter may have passed the deadline already */
+    if (since_last() >= next) {
+        TIM4->EGR = EGR_CC1G;
+    }
+}
+
+static void start(timer_channel_t channel, uint16_t duration, uint16_t period,
+                  event_t event, timer_handler_t handler)
+{
+    channel_t *c = &channels[channel];
+    uint32_t primask = irq_lock();
+    uint8_t i;
+
+    /* 'last' is only kept up to date while a channel runs */
+    for (i = 0u; i < TIMER_CHANNELS; i++) {
+        if (channels[i].running) {
+            break;
+        }
+    }
+    if (i == TIMER_CHANNELS) {
+        last = (uint16_t)hal_timer_counter_read(TIM4);
+    }
+
+    c->remaining = (uint32_t)duration * COUNTS_PER_CLOCK + since_last();
+    c->period = (uint32_t)period * COUNTS_PER_CLOCK;
+    c->event = event;
+    c->handler = handler;
+    c->running = 1u;
+
+    schedule();
+    irq_unlock(primask);
+}
 
 
 /* Interrupt service routines
@@ -37,12 +194,11 @@ static uint16_t timer_count = 0u;
 
 void TIM4_IRQHandler(void)
 {
-    if (hal_timer_irq_status(TIM4, HAL_TIMER_IRQ_UE)) {
-        hal_timer_irq_clear(TIM4, HAL_TIMER_IRQ_UE);
+    if (hal_timer_irq_status(TIM4, HAL_TIMER_IRQ_CC1)) {
+        hal_timer_irq_clear(TIM4, HAL_TIMER_IRQ_CC1);
 
-        if (timer_count > 0u) {
-            timer_count--;
-        }
+        advance();
+        schedule();
     }
 }
 
@@ -63,35 +219,57 @@ void timer_init(void)
     timer_init.prescaler = 8400u;                           // --> 10 kHz
     timer_init.mode = HAL_TIMER_MODE_UP;
     timer_init.run_mode = HAL_TIMER_RUN_CONTINOUS;
-    timer_init.count = 100u;                                // --> 100 Hz --> 10 ms
+    timer_init.count = 0xffffu;                             // free running
 
     hal_timer_init_base(TIM4, timer_init);
-    hal_timer_irq_set(TIM4, HAL_TIMER_IRQ_UE, ENABLED);
-
     hal_timer_start(TIM4);
 }
 
 /*
  * See header file
  */
-void timer_start(uint16_t duration)
+void timer_start(timer_channel_t channel, uint16_t duration, uint16_t period,
+                 event_t event)
+{
+    start(channel, duration, period, event, NULL);
+}
+
+/*
+ * See header file
+ */
+void timer_start_call(timer_channel_t channel, uint16_t duration,
+                      uint16_t period, timer_handler_t handler)
 {
-    timer_count = duration;
+    start(channel, duration, period, NO_EVENT, handler);
 }
 
 /*
  * See header file
  */
-void timer_stop(void)
+void timer_stop(timer_channel_t channel)
 {
-    timer_count = 0u;
+    uint32_t primask = irq_lock();
+
+    channels[channel].running = 0u;
+    schedule();
+    irq_unlock(primask);
 }
 
 
 /*
  * See header file
  */
-uint16_t timer_read(void)
+uint16_t timer_read(timer_channel_t channel)
 {
-    return timer_count;
+    uint32_t primask = irq_lock();
+    channel_t *c = &channels[channel];
+    uint32_t remaining = 0u;
+    uint16_t elapsed = since_last();
+
+    if (c->running && c->remaining > elapsed) {
+        remaining = c->remaining - elapsed;
+    }
+    irq_unlock(primask);
+
+    return (uint16_t)((remaining + COUNTS_PER_CLOCK - 1u) / COUNTS_PER_CLOCK);
 }
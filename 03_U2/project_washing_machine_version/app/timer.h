@@ -9,6 +9,11 @@
  * --
  * -- Description:  Interface of module timer.
  * --
+ * -- Software timers on TIM4. Each channel is a one-shot or periodic timer
+ * -- that puts its own event into the event queue, or calls a handler, when
+ * -- it runs down. TIM4 only interrupts at the next deadline, not on every
+ * -- tick, and not at all while no channel runs.
+ * --
  * -- $Id: timer.h 2690 2015-11-18 15:37:30Z fert $
  * ------------------------------------------------------------------------- */
 
@@ -19,6 +24,24 @@
 /* standard includes */
 #include <stdint.h>
 
+/* user includes */
+#include "event_handler.h"
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * One channel per user
+ */
+typedef enum {
+    TIMER_CYCLE,            // steps of the wash cycle, state_machine
+    TIMER_INPUTS,           // input sampling, event_handler
+    TIMER_CHANNELS
+} timer_channel_t;
+
+typedef void (*timer_handler_t)(void);
+
 
 /* -- Public function declarations
  * ------------------------------------------------------------------------- */
@@ -29,19 +52,28 @@
 void timer_init(void);
 
 /*
- * Start timer with specified duration (clocks of 100 Hz).
+ * Start a channel. Durations are clocks of 100 Hz.
+ * The event is put into the event queue after duration, then every period.
+ * period = 0 runs the channel once. Restarts a running channel.
+ */
+void timer_start(timer_channel_t channel, uint16_t duration, uint16_t period,
+                 event_t event);
+
+/*
+ * Same as timer_start(), calls handler from the timer interrupt instead of
+ * queueing an event.
  */
-void timer_start(uint16_t duration);
+void timer_start_call(timer_channel_t channel, uint16_t duration,
+                      uint16_t period, timer_handler_t handler);
 
 /*
- * Stop timer.
+ * Stop a channel. Its event is not queued any more.
  */
-void timer_stop(void);
+void timer_stop(timer_channel_t channel);
 
 
 /*
- * Returns actual value of timer variable.
+ * Returns the clocks of 100 Hz until a channel runs down, 0 if stopped.
  */
-uint16_t timer_read(void);
+uint16_t timer_read(timer_channel_t channel);
 #endif
-
@@ -0,0 +1,254 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module aes_auth.
+ * --
+ * --   The same construction as AES_CMAC() and AES_CCM_*() in aes.c of
+ * --   the APU, on aes_m4_encrypt() and with 32-bit lengths.
+ * --
+ * -- $Id: aes_auth.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <string.h>
+
+/* user includes */
+#include "aes_auth.h"
+
+#if AES_M4_IMPL != AES_M4_LIB
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Multiplication by x in GF(2^128), big endian as in SP 800-38B
+ */
+static void cmac_double(uint8_t *b)
+{
+    uint8_t msb = b[0] >> 7;
+
+    for (uint32_t i = 0u; i < AES_M4_BLOCKLEN - 1u; i++) {
+        b[i] = (uint8_t)((b[i] << 1) | (b[i + 1u] >> 7));
+    }
+    b[AES_M4_BLOCKLEN - 1u] = (uint8_t)((b[AES_M4_BLOCKLEN - 1u] << 1) ^ (0x87u & -msb));
+}
+
+/**
+ *  \brief  B0 and the CBC-MAC over the encoded associated data into mac,
+ *          A0 into counter
+ *  \return 0 if ok, 2 on invalid parameters
+ */
+static uint32_t ccm_start(const aes_m4_ctx_t *ctx,
+                          const uint8_t *nonce, uint32_t nonce_len,
+                          const uint8_t *aad, uint32_t aad_len,
+                          uint32_t length, uint32_t tag_len,
+                          uint8_t *mac, uint8_t *counter)
+{
+    uint32_t L = 15u - nonce_len;
+    uint8_t header[6];
+    uint32_t header_len;
+    uint32_t pos = 0u;
+
+    if ((nonce_len < 7u) || (nonce_len > 13u) || (tag_len < 4u) || (tag_len > 16u)
+        || (tag_len & 1u)) {
+        return 2u;
+    }
+    if ((L < 4u) && ((length >> (8u * L)) != 0u)) {
+        return 2u;
+    }
+
+    /* B0 = flags | nonce | message length */
+    memset(mac, 0, AES_M4_BLOCKLEN);
+    mac[0] = (uint8_t)(((aad_len > 0u) ? 0x40u : 0u) | (((tag_len - 2u) / 2u) << 3) | (L - 1u));
+    memcpy(&mac[1], nonce, nonce_len);
+    for (uint32_t i = 0u; (i < L) && (i < 4u); i++) {
+        mac[AES_M4_BLOCKLEN - 1u - i] = (uint8_t)(length >> (8u * i));
+    }
+    aes_m4_encrypt(ctx, mac, mac);
+
+    /* A0 = flags | nonce | 0, the first data block uses counter 1 */
+    memset(counter, 0, AES_M4_BLOCKLEN);
+    counter[0] = (uint8_t)(L - 1u);
+    memcpy(&counter[1], nonce, nonce_len);
+
+    if (aad_len == 0u) {
+        return 0u;
+    }
+
+    /* length prefix of the associated data */
+    if (aad_len < 0xff00u) {
+        header[0] = (uint8_t)(aad_len >> 8);
+        header[1] = (uint8_t)aad_len;
+        header_len = 2u;
+    } else {
+        header[0] = 0xffu;
+        header[1] = 0xfeu;
+        for (uint32_t i = 0u; i < 4u; i++) {
+            header[2u + i] = (uint8_t)(aad_len >> (24u - 8u * i));
+        }
+        header_len = 6u;
+    }
+
+    /* CBC-MAC over header | aad, zero padded to a block boundary */
+    for (uint32_t i = 0u; i < header_len + aad_len; i++) {
+        mac[pos++] ^= (i < header_len) ? header[i] : aad[i - header_len];
+        if (pos == AES_M4_BLOCKLEN) {
+            aes_m4_encrypt(ctx, mac, mac);
+            pos = 0u;
+        }
+    }
+    if (pos != 0u) {
+        aes_m4_encrypt(ctx, mac, mac);
+    }
+    return 0u;
+}
+
+/**
+ *  \brief  Fused CTR and CBC-MAC pass: each iteration generates one
+ *          keystream block and absorbs one plain text block into the MAC
+ */
+static void ccm_crypt(const aes_m4_ctx_t *ctx, uint8_t *buf, uint32_t length,
+                      uint8_t *mac, uint8_t *counter, uint32_t L, uint32_t decrypt)
+{
+    uint8_t keystream[AES_M4_BLOCKLEN];
+
+    while (length > 0u) {
+        uint32_t n = (length < AES_M4_BLOCKLEN) ? length : AES_M4_BLOCKLEN;
+
+        /* A_i, the counter in the last L bytes */
+        for (uint32_t i = AES_M4_BLOCKLEN - 1u; i >= AES_M4_BLOCKLEN - L; i--) {
+            if (++counter[i] != 0u) {
+                break;
+            }
+        }
+        aes_m4_encrypt(ctx, counter, keystream);
+
+        for (uint32_t i = 0u; i < n; i++) {
+            if (decrypt) {
+                buf[i] ^= keystream[i];
+                mac[i] ^= buf[i];
+            } else {
+                mac[i] ^= buf[i];
+                buf[i] ^= keystream[i];
+            }
+        }
+        aes_m4_encrypt(ctx, mac, mac);
+
+        buf += n;
+        length -= n;
+    }
+}
+
+/**
+ *  \brief  T = MAC ^ E_K(A0)
+ */
+static void ccm_finish(const aes_m4_ctx_t *ctx, uint8_t *mac, uint8_t *counter, uint32_t L)
+{
+    memset(&counter[AES_M4_BLOCKLEN - L], 0, L);
+    aes_m4_encrypt(ctx, counter, counter);
+    for (uint32_t i = 0u; i < AES_M4_BLOCKLEN; i++) {
+        mac[i] ^= counter[i];
+    }
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void aes_auth_cmac(const aes_m4_ctx_t *ctx, const uint8_t *msg, uint32_t length,
+                   uint8_t *mac)
+{
+    uint8_t subkey[AES_M4_BLOCKLEN];
+    uint32_t last = (length == 0u) ? 0u : ((length - 1u) / AES_M4_BLOCKLEN) * AES_M4_BLOCKLEN;
+
+    /* K1 = 2 * E_K(0), K2 = 4 * E_K(0) */
+    memset(subkey, 0, sizeof(subkey));
+    aes_m4_encrypt(ctx, subkey, subkey);
+    cmac_double(subkey);
+
+    /* all blocks but the last one are plain CBC-MAC */
+    memset(mac, 0, AES_M4_BLOCKLEN);
+    for (uint32_t i = 0u; i < last; i += AES_M4_BLOCKLEN) {
+        for (uint32_t j = 0u; j < AES_M4_BLOCKLEN; j++) {
+            mac[j] ^= msg[i + j];
+        }
+        aes_m4_encrypt(ctx, mac, mac);
+    }
+
+    /* a complete last block is masked with K1, a padded one with K2 */
+    for (uint32_t i = last; i < length; i++) {
+        mac[i - last] ^= msg[i];
+    }
+    if ((length - last) != AES_M4_BLOCKLEN) {
+        mac[length - last] ^= 0x80u;
+        cmac_double(subkey);
+    }
+    for (uint32_t i = 0u; i < AES_M4_BLOCKLEN; i++) {
+        mac[i] ^= subkey[i];
+    }
+    aes_m4_encrypt(ctx, mac, mac);
+}
+
+/*
+ * See header file
+ */
+uint32_t aes_auth_ccm_encrypt(const aes_m4_ctx_t *ctx,
+                              const uint8_t *nonce, uint32_t nonce_len,
+                              const uint8_t *aad, uint32_t aad_len,
+                              uint8_t *buf, uint32_t length,
+                              uint8_t *tag, uint32_t tag_len)
+{
+    uint8_t mac[AES_M4_BLOCKLEN];
+    uint8_t counter[AES_M4_BLOCKLEN];
+
+    if (ccm_start(ctx, nonce, nonce_len, aad, aad_len, length, tag_len, mac, counter) != 0u) {
+        return 2u;
+    }
+    ccm_crypt(ctx, buf, length, mac, counter, 15u - nonce_len, 0u);
+    ccm_finish(ctx, mac, counter, 15u - nonce_len);
+    memcpy(tag, mac, tag_len);
+    return 0u;
+}
+
+/*
+ * See header file
+ */
+uint32_t aes_auth_ccm_decrypt(const aes_m4_ctx_t *ctx,
+                              const uint8_t *nonce, uint32_t nonce_len,
+                              const uint8_t *aad, uint32_t aad_len,
+                              uint8_t *buf, uint32_t length,
+                              const uint8_t *tag, uint32_t tag_len)
+{
+    uint8_t mac[AES_M4_BLOCKLEN];
+    uint8_t counter[AES_M4_BLOCKLEN];
+    uint8_t diff = 0u;
+
+    if (ccm_start(ctx, nonce, nonce_len, aad, aad_len, length, tag_len, mac, counter) != 0u) {
+        return 2u;
+    }
+    ccm_crypt(ctx, buf, length, mac, counter, 15u - nonce_len, 1u);
+    ccm_finish(ctx, mac, counter, 15u - nonce_len);
+
+    /* constant time compare, no plain text is released on a mismatch */
+    for (uint32_t i = 0u; i < tag_len; i++) {
+        diff |= (uint8_t)(mac[i] ^ tag[i]);
+    }
+    if (diff != 0u) {
+        memset(buf, 0, length);
+        return 1u;
+    }
+    return 0u;
+}
+
+#endif /* AES_M4_IMPL != AES_M4_LIB */
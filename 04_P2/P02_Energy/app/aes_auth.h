@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module aes_auth.
+ *
+ *  Message authentication on the block cipher of aes_m4: AES-CMAC (NIST
+ *  SP 800-38B) and CCM (NIST SP 800-38C) for the authenticated telemetry.
+ *  CCM encrypts with CTR and authenticates with CBC-MAC in one fused pass,
+ *  each block is read and written once. Both run on the stack with a few
+ *  blocks, no tables besides those of aes_m4. Call aes_m4_init() first.
+ *
+ *  $Id: aes_auth.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _AES_AUTH_H
+#define _AES_AUTH_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+/* User includes */
+#include "aes_m4.h"
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  AES-CMAC of a message
+ *  \param  ctx    : expanded key
+ *  \param  msg    : message, may be NULL if length is 0
+ *  \param  length : bytes
+ *  \param  mac    : AES_M4_BLOCKLEN bytes out
+ */
+void aes_auth_cmac(const aes_m4_ctx_t *ctx, const uint8_t *msg, uint32_t length,
+                   uint8_t *mac);
+
+/**
+ *  \brief  CCM encryption in place
+ *  \param  ctx       : expanded key
+ *  \param  nonce     : nonce_len bytes, 7 to 13
+ *  \param  aad       : associated data, may be NULL if aad_len is 0
+ *  \param  buf       : plain text in, cipher text out
+ *  \param  tag       : tag_len bytes out, 4, 6, .. 16
+ *  \return 0 if ok, 2 on invalid parameters
+ */
+uint32_t aes_auth_ccm_encrypt(const aes_m4_ctx_t *ctx,
+                              const uint8_t *nonce, uint32_t nonce_len,
+                              const uint8_t *aad, uint32_t aad_len,
+                              uint8_t *buf, uint32_t length,
+                              uint8_t *tag, uint32_t tag_len);
+
+/**
+ *  \brief  CCM decryption in place, parameters as aes_auth_ccm_encrypt()
+ *  \return 0 if ok, 1 if the tag does not match (buf is cleared then),
+ *          2 on invalid parameters
+ */
+uint32_t aes_auth_ccm_decrypt(const aes_m4_ctx_t *ctx,
+                              const uint8_t *nonce, uint32_t nonce_len,
+                              const uint8_t *aad, uint32_t aad_len,
+                              uint8_t *buf, uint32_t length,
+                              const uint8_t *tag, uint32_t tag_len);
+
+#endif
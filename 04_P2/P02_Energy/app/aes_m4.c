@@ -0,0 +1,318 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module aes_m4.
+ * --
+ * --   The state is kept as four words, one per column, row 0 in the low
+ * --   byte. A row rotation of a column word is a ROR, which the M4 folds
+ * --   into the operand of the EOR that consumes it.
+ * --
+ * -- $Id: aes_m4.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <string.h>
+
+/* user includes */
+#include "aes_m4.h"
+#include "mem_perf.h"
+
+#if AES_M4_IMPL != AES_M4_LIB
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#if AES_M4_CODE_IN_SRAM
+#define HOT         MEM_SRAM_CODE
+#else
+#define HOT
+#endif
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32u - (n))))
+#define B0(x)       ((x) & 0xffu)
+#define B1(x)       (((x) >> 8) & 0xffu)
+#define B2(x)       (((x) >> 16) & 0xffu)
+#define B3(x)       ((x) >> 24)
+
+/* Multiply the four bytes of a word by x in GF(2^8) */
+#define XTIME32(x)  ((((x) & 0x7f7f7f7fu) << 1) ^ ((((x) >> 7) & 0x01010101u) * 0x1bu))
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static const uint8_t sbox_flash[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+/* All tables are read in the rounds, so all of them go to the CCM RAM.
+ * aes_m4_init() writes them, the CCM is not initialised at start-up. */
+static struct {
+#if AES_M4_IMPL == AES_M4_TTABLE
+    uint32_t te[256];       /* MixColumns(S(x), 0, 0, 0), rows 1..3 by ROR */
+    uint32_t td[256];       /* InvMixColumns(S^-1(x), 0, 0, 0) */
+#endif
+    uint8_t sbox[256];
+    uint8_t inv_sbox[256];
+} tables MEM_CCM;
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+static uint32_t load32(const uint8_t *p)
+{
+    uint32_t w;
+
+    memcpy(&w, p, sizeof(w));               // single LDR, M4 allows unaligned
+    return w;
+}
+
+static void store32(uint8_t *p, uint32_t w)
+{
+    memcpy(p, &w, sizeof(w));
+}
+
+static uint32_t sub_word(uint32_t w)
+{
+    return (uint32_t)tables.sbox[B0(w)]
+         | ((uint32_t)tables.sbox[B1(w)] << 8)
+         | ((uint32_t)tables.sbox[B2(w)] << 16)
+         | ((uint32_t)tables.sbox[B3(w)] << 24);
+}
+
+/* (2 3 1 1) circulant on one column word */
+static uint32_t mix_column(uint32_t w)
+{
+    uint32_t r8 = ROR(w, 8u);
+
+    return XTIME32(w ^ r8) ^ r8 ^ ROR(w, 16u) ^ ROR(w, 24u);
+}
+
+/* (14 11 13 9) = (2 3 1 1) * (5 0 4 0) */
+static uint32_t inv_mix_column(uint32_t w)
+{
+    uint32_t u = XTIME32(XTIME32(w ^ ROR(w, 16u)));
+
+    return mix_column(w ^ u);
+}
+
+#if AES_M4_IMPL == AES_M4_TTABLE
+
+#define TE(s0, s1, s2, s3, k) (tables.te[B0(s0)] ^ ROR(tables.te[B1(s1)], 24u) \
+                             ^ ROR(tables.te[B2(s2)], 16u) ^ ROR(tables.te[B3(s3)], 8u) ^ (k))
+#define TD(s0, s1, s2, s3, k) (tables.td[B0(s0)] ^ ROR(tables.td[B1(s1)], 24u) \
+                             ^ ROR(tables.td[B2(s2)], 16u) ^ ROR(tables.td[B3(s3)], 8u) ^ (k))
+#define SL(box, s0, s1, s2, s3, k) (((uint32_t)box[B0(s0)] | ((uint32_t)box[B1(s1)] << 8) \
+                             | ((uint32_t)box[B2(s2)] << 16) | ((uint32_t)box[B3(s3)] << 24)) ^ (k))
+
+HOT static void encrypt_rounds(const uint32_t *rk, uint32_t s[4])
+{
+    uint32_t s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1], s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+    uint32_t t0, t1, t2, t3;
+
+    for (uint32_t round = 1u; round < AES_M4_NR; round++) {
+        rk += 4;
+        t0 = TE(s0, s1, s2, s3, rk[0]);
+        t1 = TE(s1, s2, s3, s0, rk[1]);
+        t2 = TE(s2, s3, s0, s1, rk[2]);
+        t3 = TE(s3, s0, s1, s2, rk[3]);
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    rk += 4;
+    s[0] = SL(tables.sbox, s0, s1, s2, s3, rk[0]);
+    s[1] = SL(tables.sbox, s1, s2, s3, s0, rk[1]);
+    s[2] = SL(tables.sbox, s2, s3, s0, s1, rk[2]);
+    s[3] = SL(tables.sbox, s3, s0, s1, s2, rk[3]);
+}
+
+HOT static void decrypt_rounds(const uint32_t *rk, uint32_t s[4])
+{
+    uint32_t s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1], s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+    uint32_t t0, t1, t2, t3;
+
+    for (uint32_t round = 1u; round < AES_M4_NR; round++) {
+        rk += 4;
+        t0 = TD(s0, s3, s2, s1, rk[0]);
+        t1 = TD(s1, s0, s3, s2, rk[1]);
+        t2 = TD(s2, s1, s0, s3, rk[2]);
+        t3 = TD(s3, s2, s1, s0, rk[3]);
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    rk += 4;
+    s[0] = SL(tables.inv_sbox, s0, s3, s2, s1, rk[0]);
+    s[1] = SL(tables.inv_sbox, s1, s0, s3, s2, rk[1]);
+    s[2] = SL(tables.inv_sbox, s2, s1, s0, s3, rk[2]);
+    s[3] = SL(tables.inv_sbox, s3, s2, s1, s0, rk[3]);
+}
+
+#else /* AES_M4_COMPACT */
+
+/* SubBytes and ShiftRows, row r of column c comes from column c + r */
+static void sub_shift(uint32_t s[4], const uint8_t *box, uint32_t dir)
+{
+    uint32_t t[4];
+
+    for (uint32_t c = 0u; c < 4u; c++) {
+        t[c] = (uint32_t)box[B0(s[c])]
+             | ((uint32_t)box[B1(s[(c + dir) & 3u])] << 8)
+             | ((uint32_t)box[B2(s[(c + 2u) & 3u])] << 16)
+             | ((uint32_t)box[B3(s[(c + 4u - dir) & 3u])] << 24);
+    }
+    memcpy(s, t, sizeof(t));
+}
+
+HOT static void encrypt_rounds(const uint32_t *rk, uint32_t s[4])
+{
+    for (uint32_t c = 0u; c < 4u; c++) {
+        s[c] ^= rk[c];
+    }
+    for (uint32_t round = 1u; round <= AES_M4_NR; round++) {
+        rk += 4;
+        sub_shift(s, tables.sbox, 1u);
+        for (uint32_t c = 0u; c < 4u; c++) {
+            s[c] = (round < AES_M4_NR ? mix_column(s[c]) : s[c]) ^ rk[c];
+        }
+    }
+}
+
+HOT static void decrypt_rounds(const uint32_t *rk, uint32_t s[4])
+{
+    rk += 4u * AES_M4_NR;
+    for (uint32_t c = 0u; c < 4u; c++) {
+        s[c] ^= rk[c];
+    }
+    for (uint32_t round = AES_M4_NR; round >= 1u; round--) {
+        rk -= 4;
+        sub_shift(s, tables.inv_sbox, 3u);
+        for (uint32_t c = 0u; c < 4u; c++) {
+            s[c] ^= rk[c];
+            if (round > 1u) {
+                s[c] = inv_mix_column(s[c]);
+            }
+        }
+    }
+}
+
+#endif
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void aes_m4_init(void)
+{
+    for (uint32_t x = 0u; x < 256u; x++) {
+        uint8_t s = sbox_flash[x];
+
+        tables.sbox[x] = s;
+        tables.inv_sbox[s] = (uint8_t)x;
+    }
+#if AES_M4_IMPL == AES_M4_TTABLE
+    for (uint32_t x = 0u; x < 256u; x++) {
+        tables.te[x] = mix_column(tables.sbox[x]);
+        tables.td[x] = inv_mix_column(tables.inv_sbox[x]);
+    }
+#endif
+}
+
+/*
+ * See header file
+ */
+void aes_m4_set_key(aes_m4_ctx_t *ctx, const uint8_t *key)
+{
+    uint32_t *ek = ctx->ek;
+    uint32_t rcon = 0x01u;
+
+    for (uint32_t i = 0u; i < AES_M4_KEYLEN / 4u; i++) {
+        ek[i] = load32(&key[4u * i]);
+    }
+    for (uint32_t i = AES_M4_KEYLEN / 4u; i < AES_M4_RK_WORDS; i++) {
+        uint32_t t = ek[i - 1u];
+
+        if ((i % 8u) == 0u) {
+            t = sub_word(ROR(t, 8u)) ^ rcon;
+            rcon = XTIME32(rcon);
+        } else if ((i % 8u) == 4u) {
+            t = sub_word(t);
+        }
+        ek[i] = ek[i - 8u] ^ t;
+    }
+
+#if AES_M4_IMPL == AES_M4_TTABLE
+    /* Round keys in reverse order, InvMixColumns applied to the inner ones */
+    uint32_t *dk = ctx->dk;
+
+    for (uint32_t round = 0u; round <= AES_M4_NR; round++) {
+        for (uint32_t c = 0u; c < 4u; c++) {
+            uint32_t w = ek[4u * (AES_M4_NR - round) + c];
+
+            dk[4u * round + c] = (round == 0u || round == AES_M4_NR) ? w : inv_mix_column(w);
+        }
+    }
+#endif
+}
+
+/*
+ * See header file
+ */
+void aes_m4_encrypt(const aes_m4_ctx_t *ctx, const uint8_t *in, uint8_t *out)
+{
+    uint32_t s[4];
+
+    for (uint32_t c = 0u; c < 4u; c++) {
+        s[c] = load32(&in[4u * c]);
+    }
+    encrypt_rounds(ctx->ek, s);
+    for (uint32_t c = 0u; c < 4u; c++) {
+        store32(&out[4u * c], s[c]);
+    }
+}
+
+/*
+ * See header file
+ */
+void aes_m4_decrypt(const aes_m4_ctx_t *ctx, const uint8_t *in, uint8_t *out)
+{
+    uint32_t s[4];
+
+    for (uint32_t c = 0u; c < 4u; c++) {
+        s[c] = load32(&in[4u * c]);
+    }
+#if AES_M4_IMPL == AES_M4_TTABLE
+    decrypt_rounds(ctx->dk, s);
+#else
+    decrypt_rounds(ctx->ek, s);
+#endif
+    for (uint32_t c = 0u; c < 4u; c++) {
+        store32(&out[4u * c], s[c]);
+    }
+}
+
+#endif /* AES_M4_IMPL != AES_M4_LIB */
@@ -0,0 +1,99 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module aes_m4.
+ *
+ *  AES-256 block cipher tuned for the Cortex-M4. The implementation is
+ *  selected at build time with AES_M4_IMPL (e.g. AES_M4_IMPL=1 in the
+ *  C/C++ Define field of the project options):
+ *
+ *  AES_M4_LIB      module not built, runAES() of P02_library.lib is linked
+ *  AES_M4_COMPACT  byte S-box, MixColumns on whole column words (512 B tables)
+ *  AES_M4_TTABLE   one encryption and one decryption T-table, the other
+ *                  three rows come from the free rotate of the M4 barrel
+ *                  shifter (2.5 KiB tables)
+ *
+ *  The tables live in the 64 KiB CCM RAM at 0x10000000, which the core
+ *  reads without wait states, while flash needs 5 at 168 MHz.
+ *  With AES_M4_CODE_IN_SRAM=1 the round functions run from SRAM as well.
+ *
+ *  $Id: aes_m4.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _AES_M4_H
+#define _AES_M4_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define AES_M4_LIB          0
+#define AES_M4_COMPACT      1
+#define AES_M4_TTABLE       2
+
+#ifndef AES_M4_IMPL
+#define AES_M4_IMPL         AES_M4_TTABLE
+#endif
+
+#ifndef AES_M4_CODE_IN_SRAM
+#define AES_M4_CODE_IN_SRAM 0
+#endif
+
+#define AES_M4_KEYLEN       32u             /* AES-256, as in aes.h */
+#define AES_M4_BLOCKLEN     16u
+#define AES_M4_NR           14u
+#define AES_M4_RK_WORDS     (4u * (AES_M4_NR + 1u))
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \struct aes_m4_ctx_t
+ *  \brief  Expanded key, one little endian word per state column.
+ */
+typedef struct {
+    uint32_t ek[AES_M4_RK_WORDS];           /* encryption round keys */
+#if AES_M4_IMPL == AES_M4_TTABLE
+    uint32_t dk[AES_M4_RK_WORDS];           /* equivalent inverse cipher */
+#endif
+} aes_m4_ctx_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Builds the tables in CCM RAM, call once before the other functions
+ */
+void aes_m4_init(void);
+
+/**
+ *  \brief  Expands a key
+ *  \param  ctx : context to set up
+ *  \param  key : AES_M4_KEYLEN bytes
+ */
+void aes_m4_set_key(aes_m4_ctx_t *ctx, const uint8_t *key);
+
+/**
+ *  \brief  Encrypts one block, in and out may be the same buffer
+ */
+void aes_m4_encrypt(const aes_m4_ctx_t *ctx, const uint8_t *in, uint8_t *out);
+
+/**
+ *  \brief  Decrypts one block, in and out may be the same buffer
+ */
+void aes_m4_decrypt(const aes_m4_ctx_t *ctx, const uint8_t *in, uint8_t *out);
+
+#endif
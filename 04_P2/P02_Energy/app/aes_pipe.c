@@ -0,0 +1,240 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module aes_pipe.
+ * --
+ * --   Chunk i is encrypted in buffer i % 2. Before chunk i + 1 is loaded
+ * --   into the other buffer, the write-out of chunk i - 1 from it has to
+ * --   be complete.
+ * --
+ * -- $Id: aes_pipe.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <string.h>
+
+/* user includes */
+#include "aes_pipe.h"
+#include "aes_m4.h"
+#include "idle.h"
+#include "hal_rcc.h"
+
+#if AES_M4_IMPL != AES_M4_LIB
+
+
+/* function prototype
+ * ------------------------------------------------------------------------- */
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream1_IRQHandler(void);
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define STREAM_IN           (0u)
+#define STREAM_OUT          (1u)
+
+/* DMA2, RM0090 chapter 10.5 */
+#define DMA2_LISR           (*(volatile uint32_t *)0x40026400u)
+#define DMA2_LIFCR          (*(volatile uint32_t *)0x40026408u)
+#define DMA2_SCR(s)         (*(volatile uint32_t *)(0x40026410u + 0x18u * (s)))
+#define DMA2_SNDTR(s)       (*(volatile uint32_t *)(0x40026414u + 0x18u * (s)))
+#define DMA2_SPAR(s)        (*(volatile uint32_t *)(0x40026418u + 0x18u * (s)))
+#define DMA2_SM0AR(s)       (*(volatile uint32_t *)(0x4002641Cu + 0x18u * (s)))
+#define DMA2_SFCR(s)        (*(volatile uint32_t *)(0x40026424u + 0x18u * (s)))
+
+#define SCR_EN              (1u << 0)
+#define SCR_TEIE            (1u << 2)
+#define SCR_TCIE            (1u << 4)
+#define SCR_DIR_M2M         (2u << 6)
+#define SCR_PINC            (1u << 9)
+#define SCR_MINC            (1u << 10)
+#define SCR_PSIZE_WORD      (2u << 11)
+#define SCR_MSIZE_WORD      (2u << 13)
+#define SFCR_DMDIS          (1u << 2)       /* FIFO, required for M2M */
+#define SFCR_FTH_FULL       (3u << 0)
+
+/* Flags of stream 0 and 1 in LISR / LIFCR */
+#define FLAGS_SHIFT(s)      ((s) * 6u)
+#define FLAG_TE             (1u << 3)
+#define FLAG_TC             (1u << 5)
+#define FLAGS_ALL           (0x3du)
+
+#define NVIC_ISER1          (*(volatile uint32_t *)0xE000E104u)
+#define DMA2_STREAM0_IRQN   (56u)
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static aes_m4_ctx_t ctx;
+static uint8_t buffer[2][AES_PIPE_CHUNK] __attribute__((aligned(4)));
+static volatile uint8_t busy[2];
+static volatile uint8_t error;
+
+
+/* Interrupt service routines
+ * ------------------------------------------------------------------------- */
+
+static void stream_irq(uint32_t stream)
+{
+    uint32_t flags = (DMA2_LISR >> FLAGS_SHIFT(stream)) & FLAGS_ALL;
+
+    DMA2_LIFCR = flags << FLAGS_SHIFT(stream);
+    if (flags & FLAG_TE) {
+        error = 1u;
+    }
+    if (flags & (FLAG_TC | FLAG_TE)) {
+        busy[stream] = 0u;
+    }
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+    stream_irq(STREAM_IN);
+}
+
+void DMA2_Stream1_IRQHandler(void)
+{
+    stream_irq(STREAM_OUT);
+}
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+static void dma_start(uint32_t stream, const void *src, void *dst, uint32_t bytes)
+{
+    DMA2_SCR(stream) = 0u;
+    while (DMA2_SCR(stream) & SCR_EN) {
+        /* ends the current beat */
+    }
+    DMA2_LIFCR = FLAGS_ALL << FLAGS_SHIFT(stream);
+
+    busy[stream] = 1u;
+    DMA2_SPAR(stream) = (uint32_t)src;
+    DMA2_SM0AR(stream) = (uint32_t)dst;
+    DMA2_SNDTR(stream) = bytes / 4u;
+    DMA2_SFCR(stream) = SFCR_DMDIS | SFCR_FTH_FULL;
+    DMA2_SCR(stream) = SCR_DIR_M2M | SCR_PINC | SCR_MINC | SCR_PSIZE_WORD
+                     | SCR_MSIZE_WORD | SCR_TCIE | SCR_TEIE | SCR_EN;
+}
+
+/**
+ *  \brief  Wait conditions for idle_wait(): the stream is done
+ */
+static uint32_t in_done(void)
+{
+    return busy[STREAM_IN] == 0u;
+}
+
+static uint32_t out_done(void)
+{
+    return busy[STREAM_OUT] == 0u;
+}
+
+static void cbc_encrypt(uint8_t *buf, uint32_t length, uint8_t *chain)
+{
+    for (uint32_t i = 0u; i < length; i += AES_M4_BLOCKLEN) {
+        for (uint32_t j = 0u; j < AES_M4_BLOCKLEN; j++) {
+            buf[i + j] ^= chain[j];
+        }
+        aes_m4_encrypt(&ctx, &buf[i], &buf[i]);
+        memcpy(chain, &buf[i], AES_M4_BLOCKLEN);
+    }
+}
+
+static uint32_t chunk_length(uint32_t length, uint32_t chunk)
+{
+    uint32_t rest = length - chunk * AES_PIPE_CHUNK;
+
+    return (rest > AES_PIPE_CHUNK) ? AES_PIPE_CHUNK : rest;
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void aes_pipe_init(const uint8_t *key)
+{
+    aes_m4_init();
+    aes_m4_set_key(&ctx, key);
+
+    hal_rcc_set_peripheral(PER_DMA2, ENABLE);
+    NVIC_ISER1 = (1u << (DMA2_STREAM0_IRQN - 32u)) | (1u << (DMA2_STREAM0_IRQN + 1u - 32u));
+}
+
+/*
+ * See header file
+ */
+uint32_t aes_pipe_run(const uint8_t *src, uint8_t *dst, uint32_t length,
+                      const uint8_t *iv)
+{
+    uint32_t chunks = (length + AES_PIPE_CHUNK - 1u) / AES_PIPE_CHUNK;
+    uint8_t chain[AES_M4_BLOCKLEN];
+
+    if ((length % AES_M4_BLOCKLEN) != 0u) {
+        return 2u;
+    }
+    memcpy(chain, iv, sizeof(chain));
+    error = 0u;
+
+    if (chunks > 0u) {
+        dma_start(STREAM_IN, src, buffer[0], chunk_length(length, 0u));
+    }
+    for (uint32_t i = 0u; i < chunks; i++) {
+        uint32_t len = chunk_length(length, i);
+        uint8_t *buf = buffer[i & 1u];
+
+        idle_wait(in_done);
+
+        /* Load the next chunk while this one is encrypted */
+        idle_wait(out_done);
+        if (i + 1u < chunks) {
+            dma_start(STREAM_IN, &src[(i + 1u) * AES_PIPE_CHUNK], buffer[(i + 1u) & 1u],
+                      chunk_length(length, i + 1u));
+        }
+
+        cbc_encrypt(buf, len, chain);
+        dma_start(STREAM_OUT, buf, &dst[i * AES_PIPE_CHUNK], len);
+    }
+    idle_wait(out_done);
+
+    return error;
+}
+
+/*
+ * See header file
+ */
+uint32_t aes_pipe_run_polled(const uint8_t *src, uint8_t *dst, uint32_t length,
+                             const uint8_t *iv)
+{
+    uint32_t chunks = (length + AES_PIPE_CHUNK - 1u) / AES_PIPE_CHUNK;
+    uint8_t chain[AES_M4_BLOCKLEN];
+
+    if ((length % AES_M4_BLOCKLEN) != 0u) {
+        return 2u;
+    }
+    memcpy(chain, iv, sizeof(chain));
+
+    for (uint32_t i = 0u; i < chunks; i++) {
+        uint32_t len = chunk_length(length, i);
+
+        memcpy(buffer[0], &src[i * AES_PIPE_CHUNK], len);
+        cbc_encrypt(buffer[0], len, chain);
+        memcpy(&dst[i * AES_PIPE_CHUNK], buffer[0], len);
+    }
+    return 0u;
+}
+
+#endif /* AES_M4_IMPL != AES_M4_LIB */
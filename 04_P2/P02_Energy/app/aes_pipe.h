@@ -0,0 +1,68 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module aes_pipe.
+ *
+ *  CBC encryption of a message stream through two SRAM buffers. DMA2
+ *  stream 0 fills one buffer while the core encrypts the other one, DMA2
+ *  stream 1 writes the encrypted buffer out. Whenever the core waits for
+ *  a transfer it sleeps with WFI until the transfer complete interrupt.
+ *
+ *  aes_pipe_run_polled() does the same with memcpy() on the core, as
+ *  reference for the energy per byte.
+ *
+ *  Both directions are memory-to-memory, the only mode DMA2 offers
+ *  without a peripheral. A UART or SPI source only changes the setup of
+ *  stream 0 (peripheral-to-memory, its request channel).
+ *
+ *  $Id: aes_pipe.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _AES_PIPE_H
+#define _AES_PIPE_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define AES_PIPE_CHUNK      (256u)          /* bytes per buffer, n * 16 */
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Expands the key and enables DMA2 with its interrupts
+ *  \param  key : AES_M4_KEYLEN bytes
+ */
+void aes_pipe_init(const uint8_t *key);
+
+/**
+ *  \brief  Encrypts src into dst with CBC, data moved by DMA
+ *  \param  src    : plain text, word aligned, not in CCM RAM
+ *  \param  dst    : cipher text, word aligned, not in CCM RAM
+ *  \param  length : bytes, multiple of 16
+ *  \param  iv     : initialization vector, 16 bytes
+ *  \return 0 if ok, 1 on a DMA transfer error, 2 on a wrong length
+ */
+uint32_t aes_pipe_run(const uint8_t *src, uint8_t *dst, uint32_t length,
+                      const uint8_t *iv);
+
+/**
+ *  \brief  Same as aes_pipe_run(), data moved by the core
+ */
+uint32_t aes_pipe_run_polled(const uint8_t *src, uint8_t *dst, uint32_t length,
+                             const uint8_t *iv);
+
+#endif
@@ -0,0 +1,171 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module clock_ctx.
+ * --
+ * --   Only the RCC interrupt advances the restore, clock_ctx_resume() just
+ * --   clears the ready flags, starts the first oscillator and enables the
+ * --   interrupts. The ready interrupt flags are only latched while their
+ * --   enable is set, so the enables come before the oscillators are
+ * --   started. An oscillator that is ready already, e.g. HSE kept running,
+ * --   raises no new flag, resume() pends the interrupt for it instead.
+ * --
+ * -- $Id: clock_ctx.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+
+/* user includes */
+#include "clock_ctx.h"
+#include "idle.h"
+#include "reg_stm32f4xx.h"
+
+
+/* function prototype
+ * ------------------------------------------------------------------------- */
+void RCC_IRQHandler(void);
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define CR_HSEON            (1u << 16)
+#define CR_HSERDY           (1u << 17)
+#define CR_PLLON            (1u << 24)
+#define CR_PLLRDY           (1u << 25)
+
+#define CFGR_SW             (0x3u << 0)
+#define CFGR_SWS_SHIFT      (2u)
+#define CFGR_HPRE           (0xfu << 4)
+#define CFGR_PRE            (0xfcf0u)       /* HPRE, PPRE1, PPRE2 */
+#define CFGR_SW_HSI         (0u)
+
+#define CIR_IE              ((1u << 11) | (1u << 12))   /* HSERDYIE, PLLRDYIE */
+#define CIR_CLEAR           ((1u << 19) | (1u << 20))   /* HSERDYC, PLLRDYC */
+
+#define NVIC_ISER0          (*(volatile uint32_t *)0xE000E100u)
+#define NVIC_ISPR0          (*(volatile uint32_t *)0xE000E200u)
+#define RCC_IRQN            (5u)
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static const clock_ctx_t *volatile pending = 0;
+
+
+/* Interrupt service routines
+ * ------------------------------------------------------------------------- */
+
+void RCC_IRQHandler(void)
+{
+    const clock_ctx_t *ctx = pending;
+
+    RCC->CIR |= CIR_CLEAR;
+    if (ctx == 0) {
+        return;
+    }
+
+    if ((ctx->cr & CR_HSEON) && !(RCC->CR & CR_HSERDY)) {
+        return;
+    }
+    if (ctx->cr & CR_PLLON) {
+        if (!(RCC->CR & CR_PLLON)) {
+            RCC->CR |= CR_PLLON;            // PLLRDY interrupt follows
+            return;
+        }
+        if (!(RCC->CR & CR_PLLRDY)) {
+            return;
+        }
+    }
+
+    /* Prescalers first, then the source, HCLK never exceeds its limit */
+    RCC->CFGR = (RCC->CFGR & ~CFGR_PRE) | (ctx->cfgr & CFGR_PRE);
+    RCC->CFGR = (RCC->CFGR & ~CFGR_SW) | (ctx->cfgr & CFGR_SW);
+    while (((RCC->CFGR >> CFGR_SWS_SHIFT) & 0x3u) != (ctx->cfgr & CFGR_SW)) {
+        /* takes a few cycles */
+    }
+
+    RCC->CIR &= ~CIR_IE;
+    pending = 0;
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void clock_ctx_save(clock_ctx_t *ctx)
+{
+    ctx->cr = RCC->CR;
+    ctx->pllcfgr = RCC->PLLCFGR;
+    ctx->cfgr = RCC->CFGR;
+    ctx->acr = FLASH->ACR;
+}
+
+/*
+ * See header file
+ */
+void clock_ctx_resume(const clock_ctx_t *ctx)
+{
+    uint32_t ready;
+
+    /* More wait states than needed are fine on HSI */
+    if (FLASH->ACR != ctx->acr) {
+        FLASH->ACR = ctx->acr;
+    }
+
+    /* Nothing clobbered, e.g. woken from sleep, or HSI was in use */
+    if (((RCC->CFGR >> CFGR_SWS_SHIFT) & 0x3u) == (ctx->cfgr & CFGR_SW)) {
+        return;
+    }
+
+    /* Full HSI speed until the switch-over */
+    RCC->CFGR &= ~CFGR_HPRE;
+    if ((ctx->cr & CR_PLLON) && RCC->PLLCFGR != ctx->pllcfgr) {
+        RCC->PLLCFGR = ctx->pllcfgr;        // PLL is off after STOP
+    }
+
+    pending = ctx;
+    RCC->CIR |= CIR_CLEAR;
+    RCC->CIR |= CIR_IE;
+    NVIC_ISER0 = 1u << RCC_IRQN;
+
+    if (ctx->cr & CR_HSEON) {
+        RCC->CR |= CR_HSEON;
+        ready = CR_HSERDY;
+    } else {
+        RCC->CR |= CR_PLLON;                // PLL on HSI
+        ready = CR_PLLRDY;
+    }
+
+    /* Already running, no rising edge will set the flag */
+    if (RCC->CR & ready) {
+        NVIC_ISPR0 = 1u << RCC_IRQN;
+    }
+}
+
+/*
+ * See header file
+ */
+uint32_t clock_ctx_ready(void)
+{
+    return pending == 0;
+}
+
+/*
+ * See header file
+ */
+void clock_ctx_wait(void)
+{
+    idle_wait(clock_ctx_ready);
+}
@@ -0,0 +1,81 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module clock_ctx.
+ *
+ *  Saves the clock configuration before STOP and brings it back after
+ *  the wake-up without making the application wait for it:
+ *
+ *  clock_ctx_resume() returns at once, the core keeps running on HSI at
+ *  16 MHz with the AHB prescaler off. The RCC interrupt then turns on the
+ *  PLL as soon as HSE is ready and switches the system clock over as soon
+ *  as the PLL has locked. The first AES blocks after a wake-up are
+ *  computed while HSE starts (about 2 ms) instead of after it.
+ *
+ *  Until then the RCC ready interrupts stay enabled and end any WFI.
+ *  Call clock_ctx_wait() before a sleep or a computation that is measured
+ *  at the full clock.
+ *
+ *  STOP only clears HSEON, PLLON and the clock switch. PLLCFGR, the bus
+ *  prescalers and FLASH->ACR keep their values and are only written when
+ *  they differ from the saved ones.
+ *
+ *  $Id: clock_ctx.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _CLOCK_CTX_H
+#define _CLOCK_CTX_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \struct clock_ctx_t
+ *  \brief  Saved clock registers.
+ */
+typedef struct {
+    uint32_t cr;                /* oscillator enables */
+    uint32_t pllcfgr;
+    uint32_t cfgr;              /* prescalers and clock switch */
+    uint32_t acr;               /* flash latency and caches */
+} clock_ctx_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Records the active clock configuration
+ */
+void clock_ctx_save(clock_ctx_t *ctx);
+
+/**
+ *  \brief  Starts restoring a saved configuration after a wake-up from
+ *          STOP and returns while the core still runs on HSI. The context
+ *          has to stay valid until clock_ctx_ready() returns non-zero.
+ */
+void clock_ctx_resume(const clock_ctx_t *ctx);
+
+/**
+ *  \brief  Returns non-zero once the saved system clock is running again
+ */
+uint32_t clock_ctx_ready(void);
+
+/**
+ *  \brief  Waits until the saved system clock is running again
+ */
+void clock_ctx_wait(void);
+
+#endif
@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Source built runAES() on top of module aes_m4.
+ * --
+ * --   The linker takes a library member only for symbols that are still
+ * --   undefined, so this runAES() replaces the one in P02_library.lib
+ * --   while output, power_mode, wakeup_timer and user_button still come
+ * --   from the library. With AES_M4_IMPL = AES_M4_LIB this file is empty
+ * --   and the library version is measured instead.
+ * --
+ * -- $Id: ese_aes.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <string.h>
+
+/* user includes */
+#include "ese_aes.h"
+#include "aes_m4.h"
+
+#if AES_M4_IMPL != AES_M4_LIB
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static const uint8_t key[AES_M4_KEYLEN] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+};
+
+static const uint8_t iv[AES_M4_BLOCKLEN] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static aes_m4_ctx_t ctx;
+static uint8_t ready = 0u;
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ *
+ * CBC encryption and decryption run block by block: every block is
+ * encrypted, decrypted again and compared with a copy of the plain text.
+ * The message is unchanged afterwards and needs no buffer of its own.
+ */
+uint32_t runAES(char *message, size_t message_length)
+{
+    uint8_t *text = (uint8_t *)message;
+    uint8_t chain[AES_M4_BLOCKLEN];
+    uint8_t plain[AES_M4_BLOCKLEN];
+    uint8_t cipher[AES_M4_BLOCKLEN];
+    uint32_t error = 0u;
+
+    if ((message_length % AES_M4_BLOCKLEN) != 0u) {
+        return 2u;
+    }
+
+    if (!ready) {
+        aes_m4_init();
+        ready = 1u;
+    }
+    aes_m4_set_key(&ctx, key);
+    memcpy(chain, iv, sizeof(chain));
+
+    for (size_t i = 0u; i < message_length; i += AES_M4_BLOCKLEN) {
+        memcpy(plain, &text[i], sizeof(plain));
+        for (uint32_t j = 0u; j < AES_M4_BLOCKLEN; j++) {
+            cipher[j] = plain[j] ^ chain[j];
+        }
+        aes_m4_encrypt(&ctx, cipher, cipher);
+
+        aes_m4_decrypt(&ctx, cipher, &text[i]);
+        for (uint32_t j = 0u; j < AES_M4_BLOCKLEN; j++) {
+            text[i + j] ^= chain[j];
+        }
+        if (memcmp(&text[i], plain, sizeof(plain)) != 0) {
+            memcpy(&text[i], plain, sizeof(plain));
+            error = 1u;
+        }
+        memcpy(chain, cipher, sizeof(chain));
+    }
+
+    return error;
+}
+
+#endif /* AES_M4_IMPL != AES_M4_LIB */
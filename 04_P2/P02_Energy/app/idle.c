@@ -0,0 +1,104 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module idle.
+ * --
+ * --   STOP stops HSE and the PLL and wakes up on HSI. The clock is saved
+ * --   before and restored in the background after, see clock_ctx.
+ * --
+ * -- $Id: idle.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+
+/* user includes */
+#include "idle.h"
+#include "wakeup_timer.h"
+#include "hal_pwr.h"
+#include "clock_ctx.h"
+#include "reg_stm32f4xx.h"
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define WAKEUP_PER_MS       (16u)           /* wake-up timer runs at 16 kHz */
+
+#define SCB_SCR             (*(volatile uint32_t *)0xE000ED10u)
+#define SCB_SCR_SLEEPDEEP   (1u << 2)
+#define PWR_CR_LPDS         (1u << 0)       /* low power regulator in STOP */
+#define PWR_CR_PDDS         (1u << 1)       /* STANDBY instead of STOP */
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static clock_ctx_t saved_clock;         // still read by the RCC interrupt after return
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  STOP with low power regulator and flash powered down, until the
+ *          next interrupt
+ */
+static void enter_stop(void)
+{
+    hal_pwr_set_flash_powerdown(ENABLE);
+    PWR->CR &= ~PWR_CR_PDDS;
+    PWR->CR |= PWR_CR_LPDS;
+    SCB_SCR |= SCB_SCR_SLEEPDEEP;
+
+    __asm volatile ("dsb");
+    __asm volatile ("wfi");
+
+    SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+    PWR->CR &= ~PWR_CR_LPDS;
+    hal_pwr_set_flash_powerdown(DISABLE);
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void idle_delay_ms(uint32_t ms)
+{
+    clock_ctx_wait();                       // a restore still running
+    clock_ctx_save(&saved_clock);
+
+    while (ms > 0u) {
+        uint32_t chunk = (ms > IDLE_MAX_MS) ? IDLE_MAX_MS : ms;
+
+        wakeup_init(chunk * WAKEUP_PER_MS);
+        enter_stop();
+        ms -= chunk;
+    }
+    clock_ctx_resume(&saved_clock);
+}
+
+
+/*
+ * See header file
+ */
+void idle_wait(uint32_t (*done)(void))
+{
+    __asm volatile ("cpsid i");
+    while (!done()) {
+        __asm volatile ("wfi");
+        __asm volatile ("cpsie i");
+        __asm volatile ("isb");
+        __asm volatile ("cpsid i");
+    }
+    __asm volatile ("cpsie i");
+}
@@ -0,0 +1,58 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module idle.
+ *
+ *  Timed idle in STOP mode with the flash powered down. The RTC wake-up
+ *  timer ends the idle time. The function returns on HSI while the clock
+ *  configuration that was active before comes back in the background, see
+ *  clock_ctx. Replaces busy waiting, so the idle phase draws what a
+ *  deployed device draws. idle_wait() sleeps in SLEEP mode until a
+ *  condition set by an interrupt holds.
+ *
+ *  $Id: idle.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _IDLE_H
+#define _IDLE_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define IDLE_MAX_MS         (4095u)         /* longest single wake-up */
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Stays in STOP mode for the given time. Longer times than
+ *          IDLE_MAX_MS are split into several wake-ups. Any other
+ *          interrupt ends a wake-up early. The wake-up timer has to be
+ *          armed again by the caller afterwards if needed.
+ *  \param  ms : idle time in ms, resolution 1/16 ms of the wake-up timer
+ */
+void idle_delay_ms(uint32_t ms);
+
+/**
+ *  \brief  Sleeps in SLEEP mode until done() returns non-zero. done() is
+ *          called with interrupts masked. WFI wakes up on a pending
+ *          interrupt even while they are masked, so the interrupt that
+ *          makes done() true cannot slip in between check and WFI.
+ *  \param  done : wait condition, typically a flag set by an interrupt
+ */
+void idle_wait(uint32_t (*done)(void));
+
+#endif
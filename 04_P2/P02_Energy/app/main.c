@@ -31,6 +31,12 @@
 #include "output.h"
 #include "wakeup_timer.h"
 #include "ese_aes.h"
+#include "profile.h"
+#include "power_policy.h"
+#include "idle.h"
+#include "mem_perf.h"
+#include "clock_ctx.h"
+#include "aes_pipe.h"
 
 // END STUDENTS
 
@@ -40,6 +46,31 @@
  ***************************************************************************************/
 #define STM32F429xx
 #define CLOCK (CLOCK_168MHZ)
+#define CLOCK_HZ (168000000u)      // must match CLOCK
+#define HSI_HZ (16000000u)         // clock after a wake-up from STOP
+#define WAKEUP_PER_MS (16u)        // wake-up timer runs at 16 kHz
+
+#define AES_RUNS (2000u)
+#define IDLE_MS (300u)            // about as long as the former nop loop
+
+/* Mean currents read from the scope, 0 until measured */
+#define IDLE_CURRENT_UA (0u)
+#define AES_CURRENT_UA (0u)
+
+/* 0: fixed demo below, 1: power policy, 2: sweep of all operating points */
+#define POWER_POLICY (0)
+#define AES_CYCLES (51200000u)     // AES_RUNS runs at 168 MHz, see profile log
+#define AES_PERIOD_MS (1000u)
+
+/* 1: AES cycles per block under every flash access profile */
+#define MEM_PERF_SWEEP (0)
+
+/* 1: wake-up to first AES block, on HSI during the restore vs. after it */
+#define WAKE_LATENCY (0)
+
+/* AES state workload, 0: runAES(), 1: polled stream, 2: DMA stream */
+#define AES_PIPE (0)
+#define PIPE_RUNS (AES_RUNS * sizeof(aes_message) / sizeof(pipe_in))
 
 
 // BEGIN STUDENTS: Global variables initialization
@@ -51,12 +82,26 @@ typedef enum {
 
 static char aes_message[256] = {0};
 
+#if AES_PIPE != 0
+static uint8_t pipe_in[4096] __attribute__((aligned(4)));
+static uint8_t pipe_out[sizeof(pipe_in)] __attribute__((aligned(4)));
+static const uint8_t pipe_key[32] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+};
+static const uint8_t pipe_iv[16] = { 0 };
+#endif
+
 // END STUDENTS
 
 /* -- Local function declarations
  * ------------------------------------------------------------------------- */
 static void enable_peripherals(void);
 static void init_gpio(void);
+static void aes_work(void);
+#if WAKE_LATENCY
+static void wake_latency(void);
+#endif
 
 
 /****************************************************************************************
@@ -81,8 +126,60 @@ int main(int argc, char *argv[]) {
     output_init();
     setOutputEnable(ENABLE);
 
+    profile_init(CLOCK_HZ);
+    profile_set_current(PROFILE_IDLE, IDLE_CURRENT_UA);
+    profile_set_current(PROFILE_AES, AES_CURRENT_UA);
+
     t_state state = STATE_IDLE;
 
+#if AES_PIPE != 0
+    aes_pipe_init(pipe_key);
+#endif
+
+#if MEM_PERF_SWEEP
+    while (1) {
+        char line[32];
+
+        for (uint32_t p = 0u; p < MEM_PERF_PROFILES; p++) {
+            mem_perf_set(CLOCK, (mem_perf_t)p);
+            profile_begin(PROFILE_AES);
+            for (uint32_t i = 0; i < AES_RUNS; i++) {
+                runAES(aes_message, sizeof(aes_message));
+            }
+            profile_end(PROFILE_AES, AES_RUNS * sizeof(aes_message));
+
+            snprintf(line, sizeof(line), "mem_perf %s\n", mem_perf_name((mem_perf_t)p));
+            profile_log(line);
+            profile_report();
+        }
+        idle_delay_ms(IDLE_MS);
+        clock_ctx_wait();
+    }
+#endif
+
+#if WAKE_LATENCY
+    while (1) {
+        wake_latency();
+    }
+#endif
+
+#if POWER_POLICY != 0
+    const power_workload_t workload = {
+        aes_work, AES_RUNS, AES_RUNS * sizeof(aes_message), AES_CYCLES, AES_PERIOD_MS
+    };
+#if POWER_POLICY == 1
+    const power_op_t op = power_policy_select(&workload);
+#endif
+
+    while (1) {
+#if POWER_POLICY == 1
+        power_policy_period(&workload, op);
+#else
+        power_policy_sweep(&workload);
+#endif
+    }
+#endif
+
 	// END STUDENTS
 	while(1) {
 		// BEGIN STUDENTS: To be programmed
@@ -93,15 +190,31 @@ int main(int argc, char *argv[]) {
         switch(state)
         {
             case STATE_IDLE:
-                for (volatile uint32_t i = 0; i < 8000000; i++) {
-                    __asm volatile ("nop");
-                }
+                profile_begin(PROFILE_IDLE);
+                idle_delay_ms(IDLE_MS);
+                /* Back on the PLL before the next measured sleep and AES */
+                clock_ctx_wait();
+                profile_end(PROFILE_IDLE, 0u);
                 state = STATE_AES;
                 break;
             case STATE_AES:
-                for (uint32_t i = 0; i < 2000u; i++) {
+                profile_begin(PROFILE_AES);
+#if AES_PIPE == 0
+                for (uint32_t i = 0; i < AES_RUNS; i++) {
                     runAES(aes_message, sizeof(aes_message));
                 }
+                profile_end(PROFILE_AES, AES_RUNS * sizeof(aes_message));
+#else
+                for (uint32_t i = 0; i < PIPE_RUNS; i++) {
+#if AES_PIPE == 1
+                    aes_pipe_run_polled(pipe_in, pipe_out, sizeof(pipe_in), pipe_iv);
+#else
+                    aes_pipe_run(pipe_in, pipe_out, sizeof(pipe_in), pipe_iv);
+#endif
+                }
+                profile_end(PROFILE_AES, PIPE_RUNS * sizeof(pipe_in));
+#endif
+                profile_report();
                 state = STATE_IDLE;
                 break;
         }
@@ -113,6 +226,61 @@ int main(int argc, char *argv[]) {
 /* -- Local function definitions
  * ------------------------------------------------------------------------- */
 
+/**
+ *  \brief  One unit of work for the power policy.
+ */
+static void aes_work(void)
+{
+    runAES(aes_message, sizeof(aes_message));
+}
+
+#if WAKE_LATENCY
+/**
+ *  \brief  Cycles from the wake-up to the end of the first AES block.
+ *
+ *  First with clock_ctx: idle_delay_ms() returns on HSI and the block is
+ *  computed while HSE starts and the PLL locks in the background. Then
+ *  with the blocking restore of power_set_clock() (hal_rcc_set_osc() and
+ *  hal_rcc_setup_pll() waiting for the ready flags) before the block. The
+ *  restore runs on HSI up to the switch, so its cycles count at 16 MHz.
+ */
+static void wake_latency(void)
+{
+    char line[128];
+    uint32_t t0;
+    uint32_t hsi_block, restore, pll_block;
+
+    idle_delay_ms(IDLE_MS);
+    profile_set_clock(HSI_HZ);
+    t0 = profile_cycles();
+    profile_begin(PROFILE_AES);
+    runAES(aes_message, PROFILE_BLOCK_LEN);
+    profile_end(PROFILE_AES, PROFILE_BLOCK_LEN);
+    hsi_block = profile_cycles() - t0;
+    profile_report();
+    clock_ctx_wait();
+    profile_set_clock(CLOCK_HZ);
+
+    wakeup_init(IDLE_MS * WAKEUP_PER_MS);
+    power_enter_stop();
+    t0 = profile_cycles();
+    power_set_clock(CLOCK);
+    restore = profile_cycles() - t0;
+    profile_begin(PROFILE_AES);
+    runAES(aes_message, PROFILE_BLOCK_LEN);
+    profile_end(PROFILE_AES, PROFILE_BLOCK_LEN);
+    pll_block = profile_cycles() - t0 - restore;
+    profile_report();
+
+    snprintf(line, sizeof(line),
+             "wake hsi_cycles=%lu hsi_us=%lu blocking_cycles=%lu+%lu blocking_us=%lu\n",
+             (unsigned long)hsi_block, (unsigned long)(hsi_block / (HSI_HZ / 1000000u)),
+             (unsigned long)restore, (unsigned long)pll_block,
+             (unsigned long)(restore / (HSI_HZ / 1000000u) + pll_block / (CLOCK_HZ / 1000000u)));
+    profile_log(line);
+}
+#endif
+
 /**
  *  \brief  Enables all used peripherals.
  */
@@ -0,0 +1,93 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module mem_perf.
+ * --
+ * -- $Id: mem_perf.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+
+/* user includes */
+#include "mem_perf.h"
+#include "reg_stm32f4xx.h"
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define ACR_LATENCY         (0x7u << 0)
+#define ACR_PRFTEN          (1u << 8)
+#define ACR_ICEN            (1u << 9)
+#define ACR_DCEN            (1u << 10)
+#define ACR_ICRST           (1u << 11)
+#define ACR_DCRST           (1u << 12)
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+/* RM0090, table 10: one wait state per 30 MHz HCLK */
+static const uint32_t wait_states[] = { 5u, 3u, 2u, 1u };
+
+static const uint32_t enables[MEM_PERF_PROFILES] = {
+    0u,
+    ACR_ICEN,
+    ACR_ICEN | ACR_DCEN,
+    ACR_ICEN | ACR_DCEN | ACR_PRFTEN
+};
+
+static const char *const names[MEM_PERF_PROFILES] = {
+    "bare", "icache", "caches", "art"
+};
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+uint32_t mem_perf_wait_states(power_clk_t clock)
+{
+    return wait_states[clock];
+}
+
+/*
+ * See header file
+ */
+void mem_perf_set(power_clk_t clock, mem_perf_t profile)
+{
+    uint32_t latency = wait_states[clock];
+    uint32_t acr = FLASH->ACR;
+
+    /* Caches off, more wait states are always safe in between */
+    if ((acr & ACR_LATENCY) > latency) {
+        latency = acr & ACR_LATENCY;
+    }
+    FLASH->ACR = latency;
+
+    /* Stale lines after a time with the caches off */
+    FLASH->ACR = latency | ACR_ICRST | ACR_DCRST;
+    FLASH->ACR = latency;
+
+    FLASH->ACR = wait_states[clock] | enables[profile];
+    while ((FLASH->ACR & ACR_LATENCY) != wait_states[clock]) {
+        /* takes effect on the next access */
+    }
+}
+
+/*
+ * See header file
+ */
+const char *mem_perf_name(mem_perf_t profile)
+{
+    return names[profile];
+}
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module mem_perf.
+ *
+ *  Flash access profiles (wait states, ART prefetch, instruction and data
+ *  cache in FLASH->ACR) and the sections for code and data that should not
+ *  be read from flash at all:
+ *
+ *  MEM_SRAM_CODE   function runs from SRAM, copied there at start-up
+ *  MEM_CCM         variable in the 64 KiB CCM RAM, data only (the CCM is
+ *                  not on the instruction bus). Not initialised at start-up,
+ *                  the variable has to be written before it is read.
+ *
+ *  Both sections are placed by app/p02_energy.sct.
+ *
+ *  $Id: mem_perf.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _MEM_PERF_H
+#define _MEM_PERF_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+/* User includes */
+#include "power_mode.h"
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define MEM_SRAM_CODE       __attribute__((section(".ramfunc"), noinline))
+#if defined(__ARMCC_VERSION)
+#define MEM_CCM             __attribute__((section(".bss.ccmram")))
+#else
+#define MEM_CCM             __attribute__((section(".ccmram")))
+#endif
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \enum   mem_perf_t
+ *  \brief  Flash access profiles, each one adds to the one before.
+ */
+typedef enum {
+    MEM_PERF_BARE,                          /* wait states only */
+    MEM_PERF_ICACHE,                        /* + instruction cache */
+    MEM_PERF_CACHES,                        /* + data cache */
+    MEM_PERF_ART,                           /* + prefetch, start-up default */
+    MEM_PERF_PROFILES
+} mem_perf_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Flash wait states needed at a clock with a 2.7 to 3.6 V supply
+ */
+uint32_t mem_perf_wait_states(power_clk_t clock);
+
+/**
+ *  \brief  Sets the flash access profile. The caches are reset when they
+ *          are turned on again. Call it before the clock goes up and after
+ *          it has come down, the wait states must always fit the clock.
+ *  \param  clock   : clock the wait states are set for
+ *  \param  profile : caches and prefetch
+ */
+void mem_perf_set(power_clk_t clock, mem_perf_t profile);
+
+/**
+ *  \brief  Short name of a profile for the log
+ */
+const char *mem_perf_name(mem_perf_t profile);
+
+#endif
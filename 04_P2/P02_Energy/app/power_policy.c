@@ -0,0 +1,164 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module power_policy.
+ * --
+ * --   Energy model of one period, all currents at PROFILE_SUPPLY_MV:
+ * --
+ * --     E = U * (I_run(f) * t_run + I_idle * t_idle [+ I_wake * t_wake])
+ * --
+ * --   t_run is the cycle count of the workload divided by f. After STOP
+ * --   the clock starts on HSI and power_set_clock() has to bring up HSE
+ * --   and the PLL again, that costs t_wake.
+ * --
+ * -- $Id: power_policy.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <stdio.h>
+
+/* user includes */
+#include "power_policy.h"
+#include "power_mode.h"
+#include "wakeup_timer.h"
+#include "output.h"
+#include "profile.h"
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+#define NUM_CLOCKS          (4u)
+#define WAKEUP_PER_MS       (16u)           /* wake-up timer runs at 16 kHz */
+
+/* Typical values of the STM32F407 datasheet, peripherals off. Replace them
+ * with the currents measured on the board. */
+#define STOP_UA             (300u)          /* low power regulator, flash off */
+#define WAKE_UA             (6000u)         /* on HSI while HSE and PLL start */
+#define WAKE_US             (2000u)
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+static const uint32_t clock_mhz[NUM_CLOCKS] = { 168u, 120u, 84u, 60u };
+static const uint32_t run_ua[NUM_CLOCKS] = { 40000u, 29000u, 21000u, 15000u };
+static const uint32_t sleep_ua[NUM_CLOCKS] = { 14000u, 10000u, 7000u, 5500u };
+static const char *const idle_name[POWER_IDLE_MODES] = { "sleep", "stop" };
+
+/* Clock set by the last period, NUM_CLOCKS if unknown or lost in STOP */
+static uint32_t current_clock = NUM_CLOCKS;
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+uint32_t power_policy_estimate(const power_workload_t *work, power_op_t op)
+{
+    uint32_t period_us = work->period_ms * 1000u;
+    uint32_t run_us = work->cycles / clock_mhz[op.clock];
+    uint32_t wake_us = (op.idle == POWER_IDLE_STOP) ? WAKE_US : 0u;
+    uint64_t charge_pc;                     // uA * us
+
+    if (run_us + wake_us > period_us) {
+        return 0u;
+    }
+
+    charge_pc = (uint64_t)run_ua[op.clock] * run_us
+              + (uint64_t)WAKE_UA * wake_us;
+    if (op.idle == POWER_IDLE_STOP) {
+        charge_pc += (uint64_t)STOP_UA * (period_us - run_us - wake_us);
+    } else {
+        charge_pc += (uint64_t)sleep_ua[op.clock] * (period_us - run_us);
+    }
+
+    /* pC * mV = fJ */
+    return (uint32_t)(charge_pc * PROFILE_SUPPLY_MV / 1000000u);
+}
+
+/*
+ * See header file
+ */
+power_op_t power_policy_select(const power_workload_t *work)
+{
+    power_op_t best = { CLOCK_168MHZ, POWER_IDLE_SLEEP };
+    uint32_t best_nj = UINT32_MAX;
+
+    for (uint32_t idle = 0u; idle < POWER_IDLE_MODES; idle++) {
+        for (uint32_t clk = 0u; clk < NUM_CLOCKS; clk++) {
+            power_op_t op = { (power_clk_t)clk, (power_idle_t)idle };
+            uint32_t nj = power_policy_estimate(work, op);
+
+            if (nj != 0u && nj < best_nj) {
+                best = op;
+                best_nj = nj;
+            }
+        }
+    }
+    return best;
+}
+
+/*
+ * See header file
+ */
+void power_policy_period(const power_workload_t *work, power_op_t op)
+{
+    wakeup_init(work->period_ms * WAKEUP_PER_MS);
+
+    /* Only on a change or after STOP, when the core runs on HSI. The PLL
+     * is not reprogrammed while it is the system clock. */
+    if (current_clock != (uint32_t)op.clock) {
+        power_set_clock(op.clock);
+        profile_set_clock(clock_mhz[op.clock] * 1000000u);
+        current_clock = op.clock;
+    }
+
+    profile_begin(PROFILE_AES);
+    for (uint32_t i = 0u; i < work->runs; i++) {
+        work->run();
+    }
+    profile_end(PROFILE_AES, work->bytes);
+
+    if (op.idle == POWER_IDLE_STOP) {
+        power_enter_stop();
+        current_clock = NUM_CLOCKS;
+    } else {
+        power_enter_sleep();
+    }
+}
+
+/*
+ * See header file
+ */
+void power_policy_sweep(const power_workload_t *work)
+{
+    char line[64];
+    uint32_t step = 0u;
+
+    for (uint32_t idle = 0u; idle < POWER_IDLE_MODES; idle++) {
+        for (uint32_t clk = 0u; clk < NUM_CLOCKS; clk++) {
+            power_op_t op = { (power_clk_t)clk, (power_idle_t)idle };
+
+            output_set_red((step++ & 1u) ? ENABLE : DISABLE);
+            for (uint32_t n = 0u; n < POWER_POLICY_SWEEP_PERIODS; n++) {
+                power_policy_period(work, op);
+            }
+
+            snprintf(line, sizeof(line), "policy %luMHz %s estimate_nj=%lu\n",
+                     (unsigned long)clock_mhz[clk], idle_name[idle],
+                     (unsigned long)power_policy_estimate(work, op));
+            profile_log(line);
+            profile_report();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module power_policy.
+ *
+ *  Chooses the operating point (CPU clock and idle mode) for a periodic
+ *  workload. Every period is started by the RTC wake-up timer, the work
+ *  runs at the chosen clock and the rest of the period is spent in the
+ *  chosen idle mode:
+ *
+ *  race to idle    168 MHz, then STOP (clock is rebuilt after wake-up)
+ *  clock scaling   a lower clock, then SLEEP (clock keeps running)
+ *
+ *  and everything in between. power_policy_select() picks the point with
+ *  the lowest estimated energy that meets the deadline, the sweep runs
+ *  all of them in a row so the real optimum can be read off one capture.
+ *
+ *  $Id: power_policy.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _POWER_POLICY_H
+#define _POWER_POLICY_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+/* User includes */
+#include "power_mode.h"
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define POWER_POLICY_SWEEP_PERIODS  (5u)    /* periods per operating point */
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \enum   power_idle_t
+ *  \brief  Low power mode for the rest of a period.
+ */
+typedef enum {
+    POWER_IDLE_SLEEP,
+    POWER_IDLE_STOP,
+    POWER_IDLE_MODES
+} power_idle_t;
+
+/**
+ *  \struct power_op_t
+ *  \brief  Operating point.
+ */
+typedef struct {
+    power_clk_t clock;
+    power_idle_t idle;
+} power_op_t;
+
+/**
+ *  \struct power_workload_t
+ *  \brief  Work done once per period.
+ */
+typedef struct {
+    void (*run)(void);          /* one unit of work */
+    uint32_t runs;              /* units per period */
+    uint32_t bytes;             /* bytes per period, for the profile */
+    uint32_t cycles;            /* cycles per period, from the profile */
+    uint32_t period_ms;         /* period and deadline, at most 4095 ms */
+} power_workload_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Estimates the energy of one period at an operating point
+ *  \return Energy in nJ, 0 if the deadline cannot be met
+ */
+uint32_t power_policy_estimate(const power_workload_t *work, power_op_t op);
+
+/**
+ *  \brief  Chooses the operating point with the lowest estimated energy.
+ *          Falls back to 168 MHz and sleep if no point meets the deadline.
+ */
+power_op_t power_policy_select(const power_workload_t *work);
+
+/**
+ *  \brief  Runs one period: arm the wake-up timer, set the clock, do the
+ *          work with the green marker, idle until the wake-up
+ */
+void power_policy_period(const power_workload_t *work, power_op_t op);
+
+/**
+ *  \brief  Runs POWER_POLICY_SWEEP_PERIODS periods at every operating
+ *          point. The red marker toggles at each new point, the order is
+ *          168/120/84/60 MHz with sleep, then the same with stop.
+ */
+void power_policy_sweep(const power_workload_t *work);
+
+#endif
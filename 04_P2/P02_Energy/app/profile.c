@@ -0,0 +1,197 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ----------------------------------------------------------------------------
+ * --
+ * -- Description:  Implementation of module profile.
+ * --
+ * --   The marker is raised before the first count and cleared after the
+ * --   last one, so the pulse on the scope always encloses the counted
+ * --   cycles. Note that the counter stops while the core sleeps.
+ * --
+ * -- $Id: profile.c $
+ * ------------------------------------------------------------------------- */
+
+/* standard includes */
+#include <stdint.h>
+#include <stdio.h>
+
+/* user includes */
+#include "profile.h"
+#include "output.h"
+
+
+/* Macros
+ * ------------------------------------------------------------------------- */
+
+/* Cortex-M4 debug registers, see the ARMv7-M Architecture Reference Manual */
+#define DEMCR           (*(volatile uint32_t *)0xE000EDFCu)
+#define DEMCR_TRCENA    (1u << 24)
+#define DWT_CTRL        (*(volatile uint32_t *)0xE0001000u)
+#define DWT_CYCCNTENA   (1u << 0)
+#define DWT_CYCCNT      (*(volatile uint32_t *)0xE0001004u)
+#define ITM_PORT0       (*(volatile uint32_t *)0xE0000000u)
+#define ITM_TER         (*(volatile uint32_t *)0xE0000E00u)
+#define ITM_TCR         (*(volatile uint32_t *)0xE0000E80u)
+#define ITM_TCR_ITMENA  (1u << 0)
+
+
+/* Local variables
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t start;
+    uint32_t runs;
+    uint64_t cycles;
+    uint64_t bytes;
+    uint32_t current_ua;
+} phase_t;
+
+static const char *const phase_name[PROFILE_PHASES] = { "idle", "aes" };
+static void (*const phase_marker[PROFILE_PHASES])(hal_bool_t) = {
+    output_set_red, output_set_green
+};
+
+static phase_t phases[PROFILE_PHASES];
+static uint32_t clock_hz = 1u;
+
+
+/* Local function definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Writes a string to ITM port 0, dropped if no debugger listens
+ */
+static void itm_puts(const char *s)
+{
+    if (!(ITM_TCR & ITM_TCR_ITMENA) || !(ITM_TER & 1u)) {
+        return;
+    }
+    while (*s) {
+        while (ITM_PORT0 == 0u) {
+            /* FIFO full */
+        }
+        *(volatile uint8_t *)&ITM_PORT0 = (uint8_t)*s++;
+    }
+}
+
+
+/* Public function definitions
+ * ------------------------------------------------------------------------- */
+
+/*
+ * See header file
+ */
+void profile_init(uint32_t core_clock_hz)
+{
+    clock_hz = core_clock_hz;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0u;
+    DWT_CTRL |= DWT_CYCCNTENA;
+
+    for (uint32_t p = 0u; p < PROFILE_PHASES; p++) {
+        phases[p] = (phase_t){ 0 };
+        phase_marker[p](DISABLE);
+    }
+}
+
+/*
+ * See header file
+ */
+void profile_begin(profile_phase_t phase)
+{
+    phase_marker[phase](ENABLE);
+    phases[phase].start = DWT_CYCCNT;
+}
+
+/*
+ * See header file
+ */
+void profile_end(profile_phase_t phase, uint32_t bytes)
+{
+    uint32_t end = DWT_CYCCNT;
+    phase_t *p = &phases[phase];
+
+    phase_marker[phase](DISABLE);
+    p->cycles += (uint32_t)(end - p->start);   // wraps correctly
+    p->bytes += bytes;
+    p->runs++;
+}
+
+/*
+ * See header file
+ */
+void profile_set_clock(uint32_t core_clock_hz)
+{
+    clock_hz = core_clock_hz;
+}
+
+/*
+ * See header file
+ */
+uint32_t profile_cycles(void)
+{
+    return DWT_CYCCNT;
+}
+
+/*
+ * See header file
+ */
+void profile_log(const char *text)
+{
+    itm_puts(text);
+}
+
+/*
+ * See header file
+ */
+void profile_set_current(profile_phase_t phase, uint32_t current_ua)
+{
+    phases[phase].current_ua = current_ua;
+}
+
+/*
+ * See header file
+ */
+void profile_report(void)
+{
+    char line[160];
+
+    for (uint32_t i = 0u; i < PROFILE_PHASES; i++) {
+        phase_t *p = &phases[i];
+        uint32_t current_ua = p->current_ua;
+        int n;
+
+        if (p->runs == 0u) {
+            continue;
+        }
+        n = snprintf(line, sizeof(line), "profile %s runs=%lu cycles=%llu bytes=%llu",
+                     phase_name[i], (unsigned long)p->runs,
+                     (unsigned long long)p->cycles, (unsigned long long)p->bytes);
+
+        if (p->bytes >= PROFILE_BLOCK_LEN) {
+            uint64_t blocks = p->bytes / PROFILE_BLOCK_LEN;
+            uint64_t cycles = p->cycles / blocks;
+
+            n += snprintf(&line[n], sizeof(line) - (size_t)n,
+                          " cycles_per_block=%llu ns_per_block=%llu",
+                          (unsigned long long)cycles,
+                          (unsigned long long)(cycles * 1000000000ull / clock_hz));
+            if (current_ua != 0u) {
+                /* E = t * U * I = cycles / f * mV / 1e3 * uA / 1e6, in nJ */
+                n += snprintf(&line[n], sizeof(line) - (size_t)n, " nj_per_block=%llu",
+                              (unsigned long long)(cycles * PROFILE_SUPPLY_MV * current_ua
+                                                   / clock_hz));
+            }
+        }
+        snprintf(&line[n], sizeof(line) - (size_t)n, "\n");
+        itm_puts(line);
+
+        *p = (phase_t){ .current_ua = current_ua };
+    }
+}
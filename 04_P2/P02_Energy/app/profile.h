@@ -0,0 +1,104 @@
+/* ----------------------------------------------------------------------------
+ * --  _____       ______  _____                                              -
+ * -- |_   _|     |  ____|/ ____|                                             -
+ * --   | |  _ __ | |__  | (___    Institute of Embedded Systems              -
+ * --   | | | '_ \|  __|  \___ \   Zurich University of                       -
+ * --  _| |_| | | | |____ ____) |  Applied Sciences                           -
+ * -- |_____|_| |_|______|_____/   8401 Winterthur, Switzerland               -
+ * ------------------------------------------------------------------------- */
+/**
+ *  \brief  Interface of module profile.
+ *
+ *  Marks the phases of the measurement on the LED outputs for the scope
+ *  and counts their cycles with the DWT cycle counter. profile_report()
+ *  writes one line per phase to ITM stimulus port 0 (SWO, shown in the
+ *  "Debug (printf) Viewer" of uVision):
+ *
+ *    profile aes runs=1 cycles=57340000 bytes=512000 cycles_per_block=1791
+ *            ns_per_block=10660 nj_per_block=...
+ *
+ *  nj_per_block is only printed once the mean current of the phase, as
+ *  read from the scope, is given with profile_set_current().
+ *
+ *  $Id: profile.h $
+ * ------------------------------------------------------------------------- */
+
+/* Re-definition guard */
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+
+/* Standard includes */
+#include <stdint.h>
+
+
+/* -- Macros
+ * ------------------------------------------------------------------------- */
+
+#define PROFILE_SUPPLY_MV   (3300u)         /* supply of the measured rail */
+#define PROFILE_BLOCK_LEN   (16u)           /* bytes per AES block */
+
+
+/* -- Type definitions
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \enum   profile_phase_t
+ *  \brief  Measured phases, each one has its own marker output.
+ */
+typedef enum {
+    PROFILE_IDLE,                           /* red marker */
+    PROFILE_AES,                            /* green marker */
+    PROFILE_PHASES
+} profile_phase_t;
+
+
+/* -- Public function declarations
+ * ------------------------------------------------------------------------- */
+
+/**
+ *  \brief  Starts the cycle counter and clears all phases
+ *  \param  core_clock_hz : CPU clock, to convert cycles into time
+ */
+void profile_init(uint32_t core_clock_hz);
+
+/**
+ *  \brief  Sets the marker of a phase and takes the start count
+ */
+void profile_begin(profile_phase_t phase);
+
+/**
+ *  \brief  Takes the end count and clears the marker of a phase.
+ *          A single span must be shorter than 2^32 cycles (25 s at 168 MHz).
+ *  \param  bytes : bytes processed in the span, 0 if none
+ */
+void profile_end(profile_phase_t phase, uint32_t bytes);
+
+/**
+ *  \brief  Changes the CPU clock used to convert cycles into time
+ */
+void profile_set_clock(uint32_t core_clock_hz);
+
+/**
+ *  \brief  Returns the cycle counter, for spans outside of the phases, e.g.
+ *          across a clock switch where cycles of two clocks add up
+ */
+uint32_t profile_cycles(void);
+
+/**
+ *  \brief  Writes a line of text to the log
+ */
+void profile_log(const char *text);
+
+/**
+ *  \brief  Sets the mean current of a phase for the energy per block
+ *  \param  current_ua : current in uA, 0 to leave the energy out
+ */
+void profile_set_current(profile_phase_t phase, uint32_t current_ua);
+
+/**
+ *  \brief  Logs all phases with at least one span and clears them
+ */
+void profile_report(void);
+
+#endif
@@ -0,0 +1,202 @@
+/****************************************************************************************
+ * @file
+ * @brief Multi-threaded throughput of the APU AES wrapper
+ *
+ * @note Every thread encrypts its own buffer with its own context, pinned to one core.
+ *       The aggregate throughput is printed for 1 up to the number of online cores
+ *       (4 on the A53 cluster) together with the scaling relative to one thread.
+ *       Built with -DAES_APU_THREAD_DEFAULT=1, a second pass runs the legacy API from
+ *       all threads at once and checks the results against a single-threaded
+ *       reference, which fails if threads share the default context.
+ *
+ *       Build with "make bench", run on the board:
+ *       ./apu_bench.elf [buffer size in bytes] [passes per thread]
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "aes_apu.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define DEFAULT_BUFFER_SIZE		(64 * 1024)
+#define DEFAULT_PASSES			(16)
+#define MAX_THREADS				(8)
+#ifndef BUILD_TYPE
+#define BUILD_TYPE		"unknown"		// build profile, set by the Makefile
+#endif
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+typedef struct {
+	pthread_t thread;
+	unsigned index;
+	int legacy;					// use the legacy API on the thread-local default context
+	uint8_t *buf;
+	size_t size;
+	unsigned passes;
+	pthread_barrier_t *start;
+} worker_t;
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+
+// NIST test key and initialization vector
+static const uint8_t key[] = { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+                               0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 };
+static const uint8_t iv[]  = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/****************************************************************************************
+ * @brief Worker: per-thread IV, encrypt the buffer passes times
+ ***************************************************************************************/
+static void *worker(void *arg) {
+	worker_t *w = arg;
+	uint8_t thread_iv[sizeof(iv)];
+	aes_apu_ctx_t ctx;
+	cpu_set_t cpus;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(w->index % CPU_SETSIZE, &cpus);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+	memcpy(thread_iv, iv, sizeof(iv));
+	thread_iv[0] ^= (uint8_t)w->index;
+
+	pthread_barrier_wait(w->start);
+	if (w->legacy) {
+		AES_APU_init_ctx_iv(key, thread_iv);
+		for (unsigned p = 0; p < w->passes; p++) {
+			AES_APU_encrypt_buffer(w->buf, w->size);
+		}
+	} else {
+		AES_APU_ctx_init(&ctx, key, thread_iv);
+		for (unsigned p = 0; p < w->passes; p++) {
+			AES_APU_ctx_encrypt_buffer(&ctx, w->buf, w->size);
+		}
+		AES_APU_ctx_clear(&ctx);
+	}
+	return NULL;
+}
+
+/****************************************************************************************
+ * @brief Run n_threads workers concurrently
+ * @return Wall time in seconds, negative on failure
+ ***************************************************************************************/
+static double run(worker_t *workers, unsigned n_threads) {
+	pthread_barrier_t start;
+	double t0;
+
+	pthread_barrier_init(&start, NULL, n_threads + 1);
+	for (unsigned i = 0; i < n_threads; i++) {
+		workers[i].start = &start;
+		if (pthread_create(&workers[i].thread, NULL, worker, &workers[i]) != 0) {
+			printf("pthread_create failed\n");
+			exit(1);
+		}
+	}
+	pthread_barrier_wait(&start);
+	t0 = now_s();
+	for (unsigned i = 0; i < n_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	t0 = now_s() - t0;
+	pthread_barrier_destroy(&start);
+	return t0;
+}
+
+/****************************************************************************************
+ * @brief main
+ ***************************************************************************************/
+int main(int argc, char *argv[]) {
+	size_t size = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_BUFFER_SIZE;
+	unsigned passes = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_PASSES;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned max_threads = (cores < 1) ? 1 : (cores > MAX_THREADS) ? MAX_THREADS : (unsigned)cores;
+	worker_t workers[MAX_THREADS];
+	uint8_t *ref[MAX_THREADS];
+	double single = 0.0;
+	int failures = 0;
+
+	size -= size % AES_BLOCKLEN;
+	if (size == 0 || passes == 0) {
+		printf("usage: %s [buffer size in bytes] [passes per thread]\n", argv[0]);
+		return 1;
+	}
+
+	for (unsigned i = 0; i < max_threads; i++) {
+		workers[i] = (worker_t){ .index = i, .size = size, .passes = passes };
+		workers[i].buf = calloc(1, size);
+		ref[i] = calloc(1, size);
+		if (workers[i].buf == NULL || ref[i] == NULL) {
+			printf("out of memory\n");
+			return 1;
+		}
+	}
+
+	printf("\nAPU AES256-CBC, %zu bytes x %u passes per thread, %u cores, build %s\n",
+	       size, passes, max_threads, BUILD_TYPE);
+	printf("threads     MB/s   scaling\n");
+	for (unsigned n = 1; n <= max_threads; n++) {
+		double t = run(workers, n);
+		double mbps = (double)size * passes * n / t / 1e6;
+		if (n == 1) {
+			single = mbps;
+		}
+		printf("%7u %8.2f %8.2fx\n", n, mbps, mbps / single);
+	}
+
+#if AES_APU_THREAD_DEFAULT
+	// legacy API from all threads at once against a single-threaded reference
+	for (unsigned i = 0; i < max_threads; i++) {
+		uint8_t thread_iv[sizeof(iv)];
+		aes_apu_ctx_t ctx;
+
+		memset(workers[i].buf, (int)i, size);
+		memset(ref[i], (int)i, size);
+		workers[i].legacy = 1;
+		workers[i].passes = 2;
+
+		memcpy(thread_iv, iv, sizeof(iv));
+		thread_iv[0] ^= (uint8_t)i;
+		AES_APU_ctx_init(&ctx, key, thread_iv);
+		AES_APU_ctx_encrypt_buffer(&ctx, ref[i], size);
+		AES_APU_ctx_encrypt_buffer(&ctx, ref[i], size);
+	}
+	run(workers, max_threads);
+	for (unsigned i = 0; i < max_threads; i++) {
+		failures += (memcmp(workers[i].buf, ref[i], size) != 0);
+	}
+	printf("legacy API, %u concurrent threads: %s\n", max_threads, failures ? "FAILURE!" : "SUCCESS!");
+#else
+	printf("legacy API: one process-wide default context, concurrent pass skipped\n");
+#endif
+	for (unsigned i = 0; i < max_threads; i++) {
+		free(workers[i].buf);
+		free(ref[i]);
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+/****************************************************************************************
+ * @file
+ * @brief Differential check of all AES engines against the reference in aes_ref.c
+ *
+ * @note Every case draws a random key, IV, length and plain text. Each engine
+ *       encrypts the plain text and decrypts the reference cipher text; both results
+ *       must match the reference byte for byte. Encryption and decryption are timed
+ *       per engine in the same pass and reported as a table and as one JSON line per
+ *       engine (see timing.c).
+ *
+ *       The APU engines are always built. apu-neon forces the vector-permute path of
+ *       aes.c (aes_neon.c) for its calls only, it is skipped without Advanced SIMD.
+ *       The RPU, FPGA and CSU drivers are linked in with
+ *       "make check CHECK_ENGINES='rpu fpga csu'" on the board, otherwise their
+ *       entries are stubs and reported as skipped. The FPGA core only takes a single
+ *       block, it is checked with 16 byte cases only.
+ *
+ *       Build with "make check", run on the board:
+ *       ./apu_check.elf [cases] [max length in bytes] [seed]
+ *       The seed is printed, a failing run can be repeated with it.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aes.h"
+#include "aes_apu.h"
+#include "aes_neon.h"
+#include "aes_ref.h"
+#include "timing.h"
+#ifdef CHECK_RPU
+#include "aes_rpu.h"
+#endif
+#ifdef CHECK_FPGA
+#include "aes_fpga.h"
+#endif
+#ifdef CHECK_CSU
+#include "aes_csu.h"
+#endif
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define DEFAULT_CASES			(200)
+#define DEFAULT_MAX_LENGTH		(4096)
+#define MULTI_DECOYS			(7)			// messages sharing a multi-buffer call
+#define RPU_FIRMWARE			"aes_rpu_rtos.elf"
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+typedef enum {
+	MODE_CBC,
+	MODE_CTR,
+} check_mode_t;
+
+typedef struct {
+	const char *name;
+	check_mode_t mode;
+	size_t max_length;			// 0: no limit
+	int (*start)(void);			// NULL: nothing to start; non-zero return skips the engine
+	void (*stop)(void);
+	void (*prepare)(const uint8_t* key, const uint8_t* iv);	// NULL: none; untimed, before encrypt
+	void (*encrypt)(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
+	void (*decrypt)(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
+	const size_t *extra_bytes;	// encrypted besides the messages, counts for the throughput
+} engine_t;
+
+typedef struct {
+	int available;
+	unsigned cases;
+	unsigned failures;
+	size_t bytes;
+	timing_run_t run;
+} result_t;
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+static uint64_t rng_state;
+static size_t multi_decoy_bytes;
+static struct AES_ctx multi_ctx[MULTI_DECOYS + 1];	// message and decoys of the next call
+static size_t multi_lens[MULTI_DECOYS + 1];
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief xorshift64*, reproducible from the seed on every target
+ ***************************************************************************************/
+static uint64_t rng_next(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+static void rng_fill(uint8_t *buf, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		buf[i] = (uint8_t)(rng_next() >> 56);
+	}
+}
+
+/* ---------------- APU engines ---------------- */
+
+static void apu_encrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	aes_apu_ctx_t ctx;
+
+	AES_APU_ctx_init(&ctx, key, iv);
+	AES_APU_ctx_encrypt_buffer(&ctx, buf, length);
+	AES_APU_ctx_clear(&ctx);
+}
+
+static void apu_decrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	aes_apu_ctx_t ctx;
+
+	AES_APU_ctx_init(&ctx, key, iv);
+	AES_APU_ctx_decrypt_buffer(&ctx, buf, length);
+	AES_APU_ctx_clear(&ctx);
+}
+
+/****************************************************************************************
+ * @brief Multi-buffer CBC: the message shares the call with decoys of random key and
+ * length, so the lane scheduler is exercised as well. The contexts and lengths are
+ * set up by multi_prepare(), outside the timed span, so only AES_CBC_encrypt_multi()
+ * is timed (unlike the other engines, without the key schedule of the message).
+ ***************************************************************************************/
+static void multi_prepare(const uint8_t* key, const uint8_t* iv) {
+	uint8_t decoy_key[AES_KEYLEN];
+
+	AES_init_ctx_iv(&multi_ctx[0], key, iv);
+	for (unsigned i = 1; i <= MULTI_DECOYS; i++) {
+		rng_fill(decoy_key, sizeof(decoy_key));
+		AES_init_ctx_iv(&multi_ctx[i], decoy_key, iv);
+		multi_lens[i] = (rng_next() % (DEFAULT_MAX_LENGTH / AES_BLOCKLEN + 1)) * AES_BLOCKLEN;
+		multi_decoy_bytes += multi_lens[i];
+	}
+}
+
+static void multi_encrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	static uint8_t decoy[MULTI_DECOYS][DEFAULT_MAX_LENGTH];
+	static struct AES_ctx *ctxs[MULTI_DECOYS + 1];
+	static uint8_t *bufs[MULTI_DECOYS + 1];
+
+	(void)key;
+	(void)iv;
+	if (ctxs[0] == NULL) {
+		for (unsigned i = 0; i <= MULTI_DECOYS; i++) {
+			ctxs[i] = &multi_ctx[i];
+			bufs[i] = (i > 0) ? decoy[i - 1] : NULL;
+		}
+	}
+	bufs[0] = buf;
+	multi_lens[0] = length;
+	AES_CBC_encrypt_multi(ctxs, bufs, multi_lens, MULTI_DECOYS + 1);
+}
+
+/****************************************************************************************
+ * @brief CBC of aes.c with the vector-permute path forced: the key schedule and the
+ * whole-buffer CBC encryption of aes_neon.c, decryption from single blocks since CBC
+ * decryption goes to the bitsliced kernel with BITSLICE
+ ***************************************************************************************/
+static int neon_start(void) {
+	int ret = AES_NEON_force(1);
+
+	AES_NEON_force(0);
+	return ret;
+}
+
+static void neon_encrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	struct AES_ctx ctx;
+
+	AES_NEON_force(1);
+	AES_init_ctx_iv(&ctx, key, iv);
+	AES_CBC_encrypt_buffer(&ctx, buf, length);
+	AES_NEON_force(0);
+}
+
+static void neon_decrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	struct AES_ctx ctx;
+	uint8_t chain[AES_BLOCKLEN], next[AES_BLOCKLEN];
+
+	AES_NEON_force(1);
+	AES_init_ctx(&ctx, key);
+	memcpy(chain, iv, AES_BLOCKLEN);
+	for (size_t i = 0; i < length; i += AES_BLOCKLEN) {
+		memcpy(next, &buf[i], AES_BLOCKLEN);
+		AES_ECB_decrypt(&ctx, &buf[i]);
+		for (unsigned j = 0; j < AES_BLOCKLEN; j++) {
+			buf[i + j] ^= chain[j];
+		}
+		memcpy(chain, next, AES_BLOCKLEN);
+	}
+	AES_NEON_force(0);
+}
+
+static void ctr_xcrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	struct AES_ctx ctx;
+
+	AES_init_ctx_iv(&ctx, key, iv);
+	AES_CTR_xcrypt_buffer(&ctx, buf, length);
+}
+
+/* ---------------- target engines, stubs unless linked in ---------------- */
+
+#ifdef CHECK_RPU
+static int rpu_start(void) {
+	return (AES_RPU_start(RPU_FIRMWARE) < 0) ? -1 : 0;
+}
+
+static void rpu_stop(void) {
+	AES_RPU_stop(RPU_FIRMWARE);
+}
+#define RPU_ENGINE	rpu_start, rpu_stop, NULL, AES_RPU_encrypt_buffer, AES_RPU_decrypt_buffer, NULL
+#else
+#define RPU_ENGINE	NULL, NULL, NULL, NULL, NULL, NULL
+#endif
+
+#ifdef CHECK_FPGA
+#define FPGA_ENGINE	AES_FPGA_start, NULL, NULL, AES_FPGA_encrypt_buffer, AES_FPGA_decrypt_buffer, NULL
+#else
+#define FPGA_ENGINE	NULL, NULL, NULL, NULL, NULL, NULL
+#endif
+
+#ifdef CHECK_CSU
+static int csu_start(void) {
+	static const uint8_t probe_key[AES_KEYLEN];
+	aes_csu_session_t session;
+
+	// the driver opens its sessions on demand, probe that the transform exists
+	if (AES_CSU_session_open(&session, probe_key) != 0) {
+		return -1;
+	}
+	AES_CSU_session_close(&session);
+	return 0;
+}
+#define CSU_ENGINE	csu_start, NULL, NULL, AES_CSU_encrypt_buffer, AES_CSU_decrypt_buffer, NULL
+#else
+#define CSU_ENGINE	NULL, NULL, NULL, NULL, NULL, NULL
+#endif
+
+static const engine_t engines[] = {
+	{ "apu",       MODE_CBC, 0,  NULL, NULL, NULL, apu_encrypt, apu_decrypt, NULL },
+	{ "apu-multi", MODE_CBC, 0,  NULL, NULL, multi_prepare, multi_encrypt, apu_decrypt, &multi_decoy_bytes },
+	{ "apu-ctr",   MODE_CTR, 0,  NULL, NULL, NULL, ctr_xcrypt, ctr_xcrypt, NULL },
+	{ "apu-neon",  MODE_CBC, 0,  neon_start, NULL, NULL, neon_encrypt, neon_decrypt, NULL },
+	{ "rpu",       MODE_CBC, 0,  RPU_ENGINE },
+	{ "fpga",      MODE_CBC, 16, FPGA_ENGINE },
+	{ "csu",       MODE_CBC, 0,  CSU_ENGINE },
+};
+#define ENGINES		(sizeof(engines) / sizeof(engines[0]))
+
+/****************************************************************************************
+ * @brief Run one case through one engine
+ * @return 0 if both directions match the reference
+ ***************************************************************************************/
+static int check_case(const engine_t *e, result_t *r, const uint8_t *key, const uint8_t *iv,
+                      const uint8_t *plain, const uint8_t *cipher, uint8_t *work, size_t length) {
+	int fail = 0;
+
+	memcpy(work, plain, length);
+	if (e->prepare != NULL) {
+		e->prepare(key, iv);
+	}
+	TIMING_begin(&r->run, TIMING_ENCRYPT);
+	e->encrypt(key, iv, work, length);
+	TIMING_end(&r->run, TIMING_ENCRYPT);
+	if (memcmp(work, cipher, length) != 0) {
+		printf("  %s: encrypt mismatch, %zu bytes\n", e->name, length);
+		fail = 1;
+	}
+
+	memcpy(work, cipher, length);
+	TIMING_begin(&r->run, TIMING_DECRYPT);
+	e->decrypt(key, iv, work, length);
+	TIMING_end(&r->run, TIMING_DECRYPT);
+	if (memcmp(work, plain, length) != 0) {
+		printf("  %s: decrypt mismatch, %zu bytes\n", e->name, length);
+		fail = 1;
+	}
+
+	r->cases++;
+	r->bytes += length;
+	r->failures += fail;
+	return fail;
+}
+
+/****************************************************************************************
+ * @brief main
+ ***************************************************************************************/
+int main(int argc, char *argv[]) {
+	unsigned cases = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_CASES;
+	size_t max_length = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_MAX_LENGTH;
+	uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 0) : (uint64_t)time(NULL);
+	static result_t results[ENGINES];
+	timing_run_t ref_run[2];
+	uint8_t key[AES_REF_KEYLEN], iv[AES_REF_BLOCKLEN];
+	uint8_t *plain, *cipher[2], *work;
+	unsigned failures = 0;
+	size_t ref_bytes = 0;
+
+	max_length -= max_length % AES_REF_BLOCKLEN;
+	if (max_length == 0 || max_length > DEFAULT_MAX_LENGTH) {
+		printf("usage: %s [cases] [max length, 16..%d] [seed]\n", argv[0], DEFAULT_MAX_LENGTH);
+		return 1;
+	}
+	rng_state = seed ? seed : 1;
+
+	plain = malloc(max_length);
+	cipher[MODE_CBC] = malloc(max_length);
+	cipher[MODE_CTR] = malloc(max_length);
+	work = malloc(max_length);
+	if (!plain || !cipher[MODE_CBC] || !cipher[MODE_CTR] || !work) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	printf("\nAES256 differential check, %u cases up to %zu bytes, seed %llu, build %s\n",
+	       cases, max_length, (unsigned long long)seed, BUILD_TYPE);
+
+	for (unsigned i = 0; i < ENGINES; i++) {
+		const engine_t *e = &engines[i];
+
+		TIMING_init(&results[i].run);
+		if (e->encrypt == NULL) {
+			continue;
+		}
+		if (e->start != NULL) {
+			TIMING_begin(&results[i].run, TIMING_START);
+			int ret = e->start();
+			TIMING_end(&results[i].run, TIMING_START);
+			if (ret != 0) {
+				printf("%s: engine not available\n", e->name);
+				continue;
+			}
+		}
+		results[i].available = 1;
+	}
+	TIMING_init(&ref_run[MODE_CBC]);
+	TIMING_init(&ref_run[MODE_CTR]);
+
+	for (unsigned c = 0; c < cases; c++) {
+		size_t length = (1 + rng_next() % (max_length / AES_REF_BLOCKLEN)) * AES_REF_BLOCKLEN;
+
+		rng_fill(key, sizeof(key));
+		rng_fill(iv, sizeof(iv));
+		rng_fill(plain, length);
+		ref_bytes += length;
+
+		memcpy(cipher[MODE_CBC], plain, length);
+		TIMING_begin(&ref_run[MODE_CBC], TIMING_ENCRYPT);
+		AES_REF_cbc_encrypt(key, iv, cipher[MODE_CBC], length);
+		TIMING_end(&ref_run[MODE_CBC], TIMING_ENCRYPT);
+		memcpy(cipher[MODE_CTR], plain, length);
+		TIMING_begin(&ref_run[MODE_CTR], TIMING_ENCRYPT);
+		AES_REF_ctr_xcrypt(key, iv, cipher[MODE_CTR], length);
+		TIMING_end(&ref_run[MODE_CTR], TIMING_ENCRYPT);
+
+		// the reference itself must round trip
+		memcpy(work, cipher[MODE_CBC], length);
+		AES_REF_cbc_decrypt(key, iv, work, length);
+		if (memcmp(work, plain, length) != 0) {
+			printf("case %u: reference CBC does not round trip\n", c);
+			failures++;
+		}
+
+		for (unsigned i = 0; i < ENGINES; i++) {
+			const engine_t *e = &engines[i];
+			size_t len = length;
+
+			if (!results[i].available) {
+				continue;
+			}
+			if (e->max_length != 0 && len > e->max_length) {
+				// the reference cipher text of a prefix is the prefix of the cipher text
+				len = e->max_length;
+			}
+			if (e->mode == MODE_CTR && len > AES_REF_BLOCKLEN) {
+				// counter mode takes any length, cut a random tail off the block grid
+				len -= rng_next() % AES_REF_BLOCKLEN;
+			}
+			if (check_case(e, &results[i], key, iv, plain, cipher[e->mode], work, len) != 0) {
+				printf("case %u failed: %s, %zu bytes, seed %llu\n",
+				       c, e->name, len, (unsigned long long)seed);
+				failures++;
+			}
+		}
+	}
+
+	printf("\nengine       cases  failures   enc MB/s   dec MB/s\n");
+	for (unsigned m = MODE_CBC; m <= MODE_CTR; m++) {
+		double enc_s = ref_run[m].span[TIMING_ENCRYPT].ns * 1e-9;
+		printf("%-10s %7u %9s %10.2f %10s\n", (m == MODE_CBC) ? "ref" : "ref-ctr",
+		       cases, "-", enc_s > 0 ? ref_bytes / enc_s / 1e6 : 0.0, "-");
+	}
+	for (unsigned i = 0; i < ENGINES; i++) {
+		const result_t *r = &results[i];
+
+		if (!r->available) {
+			printf("%-10s %7s %9s %10s %10s\n", engines[i].name, "-", "-", "skipped", "-");
+			continue;
+		}
+		size_t enc_bytes = r->bytes + (engines[i].extra_bytes ? *engines[i].extra_bytes : 0);
+		double enc_s = r->run.span[TIMING_ENCRYPT].ns * 1e-9;
+		double dec_s = r->run.span[TIMING_DECRYPT].ns * 1e-9;
+		printf("%-10s %7u %9u %10.2f %10.2f\n", engines[i].name, r->cases, r->failures,
+		       enc_s > 0 ? enc_bytes / enc_s / 1e6 : 0.0, dec_s > 0 ? r->bytes / dec_s / 1e6 : 0.0);
+	}
+	printf("\n");
+	for (unsigned i = 0; i < ENGINES; i++) {
+		result_t *r = &results[i];
+
+		if (!r->available) {
+			continue;
+		}
+		if (engines[i].stop != NULL) {
+			TIMING_begin(&r->run, TIMING_TEARDOWN);
+			engines[i].stop();
+			TIMING_end(&r->run, TIMING_TEARDOWN);
+		}
+		TIMING_print_json(&r->run, engines[i].name, r->bytes, r->failures == 0);
+	}
+
+	printf("\ndifferential check: %s\n", failures ? "FAILURE!" : "SUCCESS!");
+	free(plain);
+	free(cipher[MODE_CBC]);
+	free(cipher[MODE_CTR]);
+	free(work);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+/****************************************************************************************
+ * @file
+ * @brief Known-answer tests of the standardised modes in aes.c
+ *
+ * @note The vectors are taken from the standards and compared byte for byte, in both
+ *       directions where the mode has one:
+ *       - XTS: IEEE 1619-2007 vectors 1 and 10, and the ciphertext stealing vectors
+ *         15 to 18 (17 to 20 byte data units). Data units shorter than one block
+ *         must be rejected with -1 and the buffer left as it was.
+ *       - CMAC: NIST SP 800-38B examples 1 to 4 (AES-128) and 9 to 12 (AES-256)
+ *       - CCM: NIST SP 800-38C examples 1 to 3 (AES-128). Every CCM vector is also
+ *         decrypted with one bit of the tag, of the cipher text and of the associated
+ *         data flipped; each must be rejected with -1 and a cleared buffer.
+ *
+ *       The key size is fixed per build (aes.h), every build runs the vectors of its
+ *       own key size. "make check" builds and runs this file natively for AES-128
+ *       (aes_kat128) and AES-256 (aes_kat256), it needs no board.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "aes.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define KAT_MAX_LENGTH			(512)
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+typedef struct {
+	const char *name;
+	size_t key_length;			// vector applies to this AES_KEYLEN only
+	const char *key1;			// data key, hex
+	const char *key2;			// tweak key, hex
+	uint64_t sector;			// data unit sequence number
+	const char *ptx;			// NULL: bytes 0x00, 0x01, .. of ptx_length
+	size_t ptx_length;
+	const char *ctx;
+} xts_vector_t;
+
+typedef struct {
+	const char *name;
+	size_t key_length;
+	const char *key;
+	size_t msg_length;			// prefix of cmac_msg
+	const char *mac;
+} cmac_vector_t;
+
+typedef struct {
+	const char *name;
+	size_t key_length;
+	const char *key;
+	const char *nonce;
+	const char *aad;
+	const char *ptx;
+	const char *ctx;
+	const char *tag;
+} ccm_vector_t;
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+#if defined(XTS) && (XTS == 1)
+static const xts_vector_t xts_vectors[] = {
+	{ "IEEE 1619 #1", 16,
+		"00000000000000000000000000000000",
+		"00000000000000000000000000000000",
+		0,
+		"0000000000000000000000000000000000000000000000000000000000000000", 32,
+		"917cf69ebd68b2ec9b9fe9a3eadda692cd43d2f59598ed858c02c2652fbf922e" },
+	{ "IEEE 1619 #10", 32,
+		"2718281828459045235360287471352662497757247093699959574966967627",
+		"3141592653589793238462643383279502884197169399375105820974944592",
+		0xff,
+		NULL, 512,
+		"1c3b3a102f770386e4836c99e370cf9bea00803f5e482357a4ae12d414a3e63b"
+		"5d31e276f8fe4a8d66b317f9ac683f44680a86ac35adfc3345befecb4bb188fd"
+		"5776926c49a3095eb108fd1098baec70aaa66999a72a82f27d848b21d4a741b0"
+		"c5cd4d5fff9dac89aeba122961d03a757123e9870f8acf1000020887891429ca"
+		"2a3e7a7d7df7b10355165c8b9a6d0a7de8b062c4500dc4cd120c0f7418dae3d0"
+		"b5781c34803fa75421c790dfe1de1834f280d7667b327f6c8cd7557e12ac3a0f"
+		"93ec05c52e0493ef31a12d3d9260f79a289d6a379bc70c50841473d1a8cc81ec"
+		"583e9645e07b8d9670655ba5bbcfecc6dc3966380ad8fecb17b6ba02469a020a"
+		"84e18e8f84252070c13e9f1f289be54fbc481457778f616015e1327a02b140f1"
+		"505eb309326d68378f8374595c849d84f4c333ec4423885143cb47bd71c5edae"
+		"9be69a2ffeceb1bec9de244fbe15992b11b77c040f12bd8f6a975a44a0f90c29"
+		"a9abc3d4d893927284c58754cce294529f8614dcd2aba991925fedc4ae74ffac"
+		"6e333b93eb4aff0479da9a410e4450e0dd7ae4c6e2910900575da401fc07059f"
+		"645e8b7e9bfdef33943054ff84011493c27b3429eaedb4ed5376441a77ed4385"
+		"1ad77f16f541dfd269d50d6a5f14fb0aab1cbb4c1550be97f7ab4066193c4caa"
+		"773dad38014bd2092fa755c824bb5e54c4f36ffda9fcea70b9c6e693e148c151" },
+	{ "IEEE 1619 #15", 16,
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0",
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aull,
+		NULL, 17,
+		"6c1625db4671522d3d7599601de7ca09ed" },
+	{ "IEEE 1619 #16", 16,
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0",
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aull,
+		NULL, 18,
+		"d069444b7a7e0cab09e24447d24deb1fedbf" },
+	{ "IEEE 1619 #17", 16,
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0",
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aull,
+		NULL, 19,
+		"e5df1351c0544ba1350b3363cd8ef4beedbf9d" },
+	{ "IEEE 1619 #18", 16,
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0",
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aull,
+		NULL, 20,
+		"9d84c813f719aa2c7be3f66171c7c5c2edbf9dac" },
+};
+#endif
+
+#if defined(CMAC) && (CMAC == 1)
+// Message of SP 800-38B, the examples use its first 0, 16, 40 and 64 bytes
+static const char cmac_msg[] =
+		"6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+static const cmac_vector_t cmac_vectors[] = {
+	{ "SP 800-38B #1", 16, "2b7e151628aed2a6abf7158809cf4f3c",  0, "bb1d6929e95937287fa37d129b756746" },
+	{ "SP 800-38B #2", 16, "2b7e151628aed2a6abf7158809cf4f3c", 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+	{ "SP 800-38B #3", 16, "2b7e151628aed2a6abf7158809cf4f3c", 40, "dfa66747de9ae63030ca32611497c827" },
+	{ "SP 800-38B #4", 16, "2b7e151628aed2a6abf7158809cf4f3c", 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+	{ "SP 800-38B #9", 32, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		 0, "028962f61b7bf89efc6b551f4667d983" },
+	{ "SP 800-38B #10", 32, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		16, "28a7023f452e8f82bd4bf28d8c37c35c" },
+	{ "SP 800-38B #11", 32, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		40, "aaf3d8f1de5640c232f5b169b9c911e6" },
+	{ "SP 800-38B #12", 32, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		64, "e1992190549f6ed5696a2c056c315410" },
+};
+#endif
+
+#if defined(CCM) && (CCM == 1)
+static const ccm_vector_t ccm_vectors[] = {
+	{ "SP 800-38C #1", 16, "404142434445464748494a4b4c4d4e4f",
+		"10111213141516",
+		"0001020304050607",
+		"20212223",
+		"7162015b",
+		"4dac255d" },
+	{ "SP 800-38C #2", 16, "404142434445464748494a4b4c4d4e4f",
+		"1011121314151617",
+		"000102030405060708090a0b0c0d0e0f",
+		"202122232425262728292a2b2c2d2e2f",
+		"d2a1f0e051ea5f62081a7792073d593d",
+		"1fc64fbfaccd" },
+	{ "SP 800-38C #3", 16, "404142434445464748494a4b4c4d4e4f",
+		"101112131415161718191a1b",
+		"000102030405060708090a0b0c0d0e0f10111213",
+		"202122232425262728292a2b2c2d2e2f3031323334353637",
+		"e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5",
+		"484392fbc1b09951" },
+};
+#endif
+
+static unsigned kat_run;
+static unsigned kat_failures;
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Decode a hex string into buf, the string length must be even
+ * @return number of bytes written
+ ***************************************************************************************/
+static size_t from_hex(const char *hex, uint8_t *buf) {
+	size_t n = 0;
+
+	for (; hex[0] && hex[1]; hex += 2) {
+		unsigned byte;
+		sscanf(hex, "%2x", &byte);
+		buf[n++] = (uint8_t)byte;
+	}
+	return n;
+}
+
+/****************************************************************************************
+ * @brief Compare a result with the expected bytes and record it
+ ***************************************************************************************/
+static void kat_expect(const char *name, const char *what, const uint8_t *got,
+		const uint8_t *expected, size_t length) {
+	int fail = memcmp(got, expected, length) != 0;
+
+	kat_run++;
+	kat_failures += fail;
+	printf("%-16s %-10s %s\n", name, what, fail ? "FAILURE!" : "ok");
+}
+
+#if defined(XTS) && (XTS == 1)
+static void kat_xts(const xts_vector_t *v) {
+	uint8_t key1[AES_KEYLEN], key2[AES_KEYLEN];
+	uint8_t ptx[KAT_MAX_LENGTH], ctx[KAT_MAX_LENGTH], buf[KAT_MAX_LENGTH];
+	struct AES_xts_ctx xts;
+	int ret;
+
+	from_hex(v->key1, key1);
+	from_hex(v->key2, key2);
+	if (v->ptx) {
+		from_hex(v->ptx, ptx);
+	} else {
+		for (size_t i = 0; i < v->ptx_length; i++) {
+			ptx[i] = (uint8_t)i;
+		}
+	}
+	from_hex(v->ctx, ctx);
+	AES_XTS_init_ctx(&xts, key1, key2);
+
+	memcpy(buf, ptx, v->ptx_length);
+	ret = AES_XTS_encrypt_sector(&xts, v->sector, buf, v->ptx_length);
+	kat_expect(v->name, "encrypt", buf, ctx, v->ptx_length);
+	kat_failures += (ret != 0);
+
+	ret = AES_XTS_decrypt_sector(&xts, v->sector, buf, v->ptx_length);
+	kat_expect(v->name, "decrypt", buf, ptx, v->ptx_length);
+	kat_failures += (ret != 0);
+}
+
+/****************************************************************************************
+ * @brief Data units below one block have no XTS encoding, they must be rejected
+ ***************************************************************************************/
+static void kat_xts_short(void) {
+	static const size_t lengths[] = { 0, 1, AES_BLOCKLEN - 1 };
+	uint8_t key[AES_KEYLEN] = { 0 };
+	uint8_t ptx[AES_BLOCKLEN], buf[AES_BLOCKLEN];
+	struct AES_xts_ctx xts;
+
+	for (size_t i = 0; i < sizeof(ptx); i++) {
+		ptx[i] = (uint8_t)i;
+	}
+	AES_XTS_init_ctx(&xts, key, key);
+
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		char name[16];
+		int ret, fail;
+
+		snprintf(name, sizeof(name), "XTS %u bytes", (unsigned)lengths[i]);
+		memcpy(buf, ptx, sizeof(buf));
+		ret = AES_XTS_encrypt_sector(&xts, 0, buf, lengths[i]);
+		fail = (ret != -1) || memcmp(buf, ptx, sizeof(buf)) != 0;
+		ret = AES_XTS_decrypt_sector(&xts, 0, buf, lengths[i]);
+		fail |= (ret != -1) || memcmp(buf, ptx, sizeof(buf)) != 0;
+
+		kat_run++;
+		kat_failures += fail;
+		printf("%-16s %-10s %s\n", name, "reject", fail ? "FAILURE!" : "ok");
+	}
+}
+#endif
+
+#if defined(CMAC) && (CMAC == 1)
+static void kat_cmac(const cmac_vector_t *v) {
+	uint8_t key[AES_KEYLEN], msg[KAT_MAX_LENGTH], expected[AES_BLOCKLEN], mac[AES_BLOCKLEN];
+	struct AES_ctx ctx;
+
+	from_hex(v->key, key);
+	from_hex(cmac_msg, msg);
+	from_hex(v->mac, expected);
+	AES_init_ctx(&ctx, key);
+
+	AES_CMAC(&ctx, msg, v->msg_length, mac);
+	kat_expect(v->name, "mac", mac, expected, AES_BLOCKLEN);
+}
+#endif
+
+#if defined(CCM) && (CCM == 1)
+/****************************************************************************************
+ * @brief Decrypt a tampered message, it must be rejected and the buffer cleared
+ ***************************************************************************************/
+static void kat_ccm_reject(const char *name, const char *what, const struct AES_ctx *ctx,
+		const uint8_t *nonce, size_t nonce_len, const uint8_t *aad, size_t aad_len,
+		uint8_t *buf, size_t length, const uint8_t *tag, size_t tag_len) {
+	static const uint8_t zero[KAT_MAX_LENGTH];
+	int ret = AES_CCM_decrypt(ctx, nonce, nonce_len, aad, aad_len, buf, length, tag, tag_len);
+	int fail = (ret != -1) || memcmp(buf, zero, length) != 0;
+
+	kat_run++;
+	kat_failures += fail;
+	printf("%-16s %-10s %s\n", name, what, fail ? "FAILURE!" : "ok");
+}
+
+static void kat_ccm(const ccm_vector_t *v) {
+	uint8_t key[AES_KEYLEN], nonce[16], aad[KAT_MAX_LENGTH];
+	uint8_t ptx[KAT_MAX_LENGTH], ctx_expected[KAT_MAX_LENGTH], buf[KAT_MAX_LENGTH];
+	uint8_t tag_expected[AES_BLOCKLEN], tag[AES_BLOCKLEN];
+	struct AES_ctx ctx;
+	size_t nonce_len, aad_len, length, tag_len;
+	int ret;
+
+	from_hex(v->key, key);
+	nonce_len = from_hex(v->nonce, nonce);
+	aad_len = from_hex(v->aad, aad);
+	length = from_hex(v->ptx, ptx);
+	from_hex(v->ctx, ctx_expected);
+	tag_len = from_hex(v->tag, tag_expected);
+	AES_init_ctx(&ctx, key);
+
+	memcpy(buf, ptx, length);
+	ret = AES_CCM_encrypt(&ctx, nonce, nonce_len, aad, aad_len, buf, length, tag, tag_len);
+	kat_expect(v->name, "encrypt", buf, ctx_expected, length);
+	kat_expect(v->name, "tag", tag, tag_expected, tag_len);
+	kat_failures += (ret != 0);
+
+	ret = AES_CCM_decrypt(&ctx, nonce, nonce_len, aad, aad_len, buf, length, tag_expected, tag_len);
+	kat_expect(v->name, "decrypt", buf, ptx, length);
+	kat_failures += (ret != 0);
+
+	memcpy(tag, tag_expected, tag_len);
+	tag[tag_len - 1] ^= 0x01;
+	memcpy(buf, ctx_expected, length);
+	kat_ccm_reject(v->name, "bad tag", &ctx, nonce, nonce_len, aad, aad_len, buf, length, tag, tag_len);
+
+	memcpy(buf, ctx_expected, length);
+	buf[0] ^= 0x80;
+	kat_ccm_reject(v->name, "bad data", &ctx, nonce, nonce_len, aad, aad_len, buf, length,
+			tag_expected, tag_len);
+
+	aad[aad_len - 1] ^= 0x01;
+	memcpy(buf, ctx_expected, length);
+	kat_ccm_reject(v->name, "bad aad", &ctx, nonce, nonce_len, aad, aad_len, buf, length,
+			tag_expected, tag_len);
+}
+#endif
+
+/****************************************************************************************
+ * @brief Main function
+ ***************************************************************************************/
+int main(void) {
+	printf("\nAES-%d known-answer tests\n", AES_KEYLEN * 8);
+
+#if defined(XTS) && (XTS == 1)
+	for (size_t i = 0; i < sizeof(xts_vectors) / sizeof(xts_vectors[0]); i++) {
+		if (xts_vectors[i].key_length == AES_KEYLEN) {
+			kat_xts(&xts_vectors[i]);
+		}
+	}
+	kat_xts_short();
+#endif
+
+#if defined(CMAC) && (CMAC == 1)
+	for (size_t i = 0; i < sizeof(cmac_vectors) / sizeof(cmac_vectors[0]); i++) {
+		if (cmac_vectors[i].key_length == AES_KEYLEN) {
+			kat_cmac(&cmac_vectors[i]);
+		}
+	}
+#endif
+
+#if defined(CCM) && (CCM == 1)
+	for (size_t i = 0; i < sizeof(ccm_vectors) / sizeof(ccm_vectors[0]); i++) {
+		if (ccm_vectors[i].key_length == AES_KEYLEN) {
+			kat_ccm(&ccm_vectors[i]);
+		}
+	}
+#endif
+
+	printf("\nknown-answer tests: %u run, %s\n", kat_run,
+			(kat_failures || !kat_run) ? "FAILURE!" : "SUCCESS!");
+	return (kat_failures || !kat_run) ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/****************************************************************************************
+ * @file
+ * @brief Straightforward AES-256 after FIPS-197, the reference for aes_check.c
+ *
+ * @note Written for clarity, not speed, and independent of src/aes.c: the S-box is
+ * computed from the field inverse and the affine map instead of being copied from a
+ * table, every round step works byte by byte on the state.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <string.h>
+#include "aes_ref.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define NK		(8)			// key words
+#define NR		(14)		// rounds
+
+static uint8_t sbox[256];
+static uint8_t inv_sbox[256];
+static int sbox_ready;
+
+/****************************************************************************************
+ * Local Functions
+ ***************************************************************************************/
+
+static uint8_t xtime(uint8_t x) {
+	return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+static uint8_t gmul(uint8_t a, uint8_t b) {
+	uint8_t p = 0;
+
+	while (b) {
+		if (b & 1) {
+			p ^= a;
+		}
+		a = xtime(a);
+		b >>= 1;
+	}
+	return p;
+}
+
+static uint8_t rotl8(uint8_t x, unsigned n) {
+	return (uint8_t)((x << n) | (x >> (8 - n)));
+}
+
+/****************************************************************************************
+ * @brief S-box: multiplicative inverse in GF(2^8) (x^254), then the affine map
+ ***************************************************************************************/
+static void build_sbox(void) {
+	for (unsigned x = 0; x < 256; x++) {
+		uint8_t inv = 0;
+
+		if (x != 0) {
+			inv = 1;
+			for (unsigned i = 0; i < 254; i++) {
+				inv = gmul(inv, (uint8_t)x);
+			}
+		}
+		uint8_t s = inv ^ rotl8(inv, 1) ^ rotl8(inv, 2) ^ rotl8(inv, 3) ^ rotl8(inv, 4) ^ 0x63;
+		sbox[x] = s;
+		inv_sbox[s] = (uint8_t)x;
+	}
+	sbox_ready = 1;
+}
+
+/****************************************************************************************
+ * @brief Key expansion, (NR + 1) round keys of 16 bytes
+ ***************************************************************************************/
+static void key_expansion(uint8_t* rk, const uint8_t* key) {
+	uint8_t rcon = 1;
+
+	if (!sbox_ready) {
+		build_sbox();
+	}
+	memcpy(rk, key, AES_REF_KEYLEN);
+	for (unsigned i = NK; i < 4 * (NR + 1); i++) {
+		uint8_t t[4];
+
+		memcpy(t, &rk[4 * (i - 1)], 4);
+		if (i % NK == 0) {
+			uint8_t t0 = t[0];
+			t[0] = sbox[t[1]] ^ rcon;
+			t[1] = sbox[t[2]];
+			t[2] = sbox[t[3]];
+			t[3] = sbox[t0];
+			rcon = xtime(rcon);
+		} else if (i % NK == 4) {
+			for (unsigned j = 0; j < 4; j++) {
+				t[j] = sbox[t[j]];
+			}
+		}
+		for (unsigned j = 0; j < 4; j++) {
+			rk[4 * i + j] = rk[4 * (i - NK) + j] ^ t[j];
+		}
+	}
+}
+
+/* The state is the block itself: byte r + 4c is row r of column c */
+
+static void add_round_key(uint8_t* s, const uint8_t* rk) {
+	for (unsigned i = 0; i < 16; i++) {
+		s[i] ^= rk[i];
+	}
+}
+
+static void sub_bytes(uint8_t* s, const uint8_t* box) {
+	for (unsigned i = 0; i < 16; i++) {
+		s[i] = box[s[i]];
+	}
+}
+
+static void shift_rows(uint8_t* s, int inverse) {
+	uint8_t t[16];
+
+	for (unsigned r = 0; r < 4; r++) {
+		for (unsigned c = 0; c < 4; c++) {
+			unsigned from = inverse ? (c + 4 - r) % 4 : (c + r) % 4;
+			t[r + 4 * c] = s[r + 4 * from];
+		}
+	}
+	memcpy(s, t, 16);
+}
+
+static void mix_columns(uint8_t* s, int inverse) {
+	static const uint8_t fwd[4] = { 2, 3, 1, 1 };
+	static const uint8_t inv[4] = { 14, 11, 13, 9 };
+	const uint8_t *m = inverse ? inv : fwd;
+
+	for (unsigned c = 0; c < 4; c++) {
+		uint8_t col[4];
+
+		memcpy(col, &s[4 * c], 4);
+		for (unsigned r = 0; r < 4; r++) {
+			s[4 * c + r] = gmul(col[0], m[(4 - r) % 4]) ^ gmul(col[1], m[(5 - r) % 4])
+			             ^ gmul(col[2], m[(6 - r) % 4]) ^ gmul(col[3], m[(7 - r) % 4]);
+		}
+	}
+}
+
+static void encrypt_block(const uint8_t* rk, uint8_t* s) {
+	add_round_key(s, rk);
+	for (unsigned round = 1; round <= NR; round++) {
+		sub_bytes(s, sbox);
+		shift_rows(s, 0);
+		if (round != NR) {
+			mix_columns(s, 0);
+		}
+		add_round_key(s, rk + 16 * round);
+	}
+}
+
+static void decrypt_block(const uint8_t* rk, uint8_t* s) {
+	add_round_key(s, rk + 16 * NR);
+	for (unsigned round = NR; round >= 1; round--) {
+		shift_rows(s, 1);
+		sub_bytes(s, inv_sbox);
+		add_round_key(s, rk + 16 * (round - 1));
+		if (round != 1) {
+			mix_columns(s, 1);
+		}
+	}
+}
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief CBC encryption
+ * @param key[in]		Key (AES_REF_KEYLEN bytes)
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Plain text in, cipher text out
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ ***************************************************************************************/
+void AES_REF_cbc_encrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	uint8_t rk[16 * (NR + 1)];
+	const uint8_t *chain = iv;
+
+	key_expansion(rk, key);
+	for (size_t i = 0; i < length; i += AES_REF_BLOCKLEN) {
+		add_round_key(buf + i, chain);
+		encrypt_block(rk, buf + i);
+		chain = buf + i;
+	}
+}
+
+/****************************************************************************************
+ * @brief CBC decryption
+ * @param key[in]		Key (AES_REF_KEYLEN bytes)
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Cipher text in, plain text out
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ ***************************************************************************************/
+void AES_REF_cbc_decrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	uint8_t rk[16 * (NR + 1)];
+	uint8_t chain[AES_REF_BLOCKLEN], next[AES_REF_BLOCKLEN];
+
+	key_expansion(rk, key);
+	memcpy(chain, iv, AES_REF_BLOCKLEN);
+	for (size_t i = 0; i < length; i += AES_REF_BLOCKLEN) {
+		memcpy(next, buf + i, AES_REF_BLOCKLEN);
+		decrypt_block(rk, buf + i);
+		add_round_key(buf + i, chain);
+		memcpy(chain, next, AES_REF_BLOCKLEN);
+	}
+}
+
+/****************************************************************************************
+ * @brief CTR en-/decryption, 128 bit big endian counter starting at iv
+ * @param key[in]		Key (AES_REF_KEYLEN bytes)
+ * @param iv[in]		Initial counter block
+ * @param buf[in/out]	Text
+ * @param length[in]	Length of text, any
+ ***************************************************************************************/
+void AES_REF_ctr_xcrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	uint8_t rk[16 * (NR + 1)];
+	uint8_t counter[AES_REF_BLOCKLEN], stream[AES_REF_BLOCKLEN];
+
+	key_expansion(rk, key);
+	memcpy(counter, iv, AES_REF_BLOCKLEN);
+	for (size_t i = 0; i < length; i += AES_REF_BLOCKLEN) {
+		memcpy(stream, counter, AES_REF_BLOCKLEN);
+		encrypt_block(rk, stream);
+		for (size_t j = 0; j < AES_REF_BLOCKLEN && i + j < length; j++) {
+			buf[i + j] ^= stream[j];
+		}
+		for (int j = AES_REF_BLOCKLEN - 1; j >= 0 && ++counter[j] == 0; j--) {
+		}
+	}
+}
@@ -0,0 +1,28 @@
+/****************************************************************************************
+ * @file
+ * @brief See aes_ref.c
+ ***************************************************************************************/
+
+#ifndef AES_REF_H
+#define AES_REF_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define AES_REF_KEYLEN		(32)
+#define AES_REF_BLOCKLEN	(16)
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+void AES_REF_cbc_encrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
+void AES_REF_cbc_decrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
+void AES_REF_ctr_xcrypt(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
+
+#endif  /* AES_REF_H */
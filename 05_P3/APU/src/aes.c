@@ -25,6 +25,20 @@ ECB-AES128
     7b0c785e27e8ad3f8223207104725dd4
 
 
+XTS-AES-256 is verified against IEEE Std 1619-2007, e.g. Vector 10:
+
+  key1:
+    2718281828459045235360287471352662497757247093699959574966967627
+  key2:
+    3141592653589793238462643383279502884197169399375105820974944592
+  data unit sequence number: ff
+  plain-text: 000102..ff000102..ff (512 bytes)
+
+  resulting cipher (first blocks)
+    1c3b3a102f770386e4836c99e370cf9b
+    ea00803f5e482357a4ae12d414a3e63b
+
+
 NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
         You should pad the end of the string with zeros if this is not the case.
         For AES192/256 the key size is proportionally larger.
@@ -37,6 +51,12 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
 /*****************************************************************************/
 #include <string.h> // CBC mode, for memset
 #include "aes.h"
+#if defined(BITSLICE) && (BITSLICE == 1)
+#include "aes_bitslice.h"
+#endif
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+#include "aes_neon.h"
+#endif
 
 /*****************************************************************************/
 /* Defines:                                                                  */
@@ -95,7 +115,7 @@ static const uint8_t sbox[256] = {
   0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
   0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
 
-#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
 static const uint8_t rsbox[256] = {
   0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
   0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
@@ -142,12 +162,36 @@ static uint8_t getSBoxValue(uint8_t num)
 */
 #define getSBoxValue(num) (sbox[(num)])
 
+// SubWord() is a function that takes a four-byte input word and
+// applies the S-box to each of the four bytes to produce an output word.
+static void SubWord(uint8_t* tempa)
+{
+#if defined(BITSLICE) && (BITSLICE == 1)
+  // the key is secret as well, keep the schedule off the table
+  AES_BS_sub_word(tempa);
+  return;
+#endif
+  tempa[0] = getSBoxValue(tempa[0]);
+  tempa[1] = getSBoxValue(tempa[1]);
+  tempa[2] = getSBoxValue(tempa[2]);
+  tempa[3] = getSBoxValue(tempa[3]);
+}
+
 // This function produces Nb(Nr+1) round keys. The round keys are used in each round to decrypt the states.
 static void KeyExpansion(uint8_t* RoundKey, const uint8_t* Key)
 {
   unsigned i, j, k;
   uint8_t tempa[4]; // Used for the column/row operations
 
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  // the whole schedule in one call, the S-box is loaded into registers once
+  if (AES_NEON_available())
+  {
+    AES_NEON_key_expansion(RoundKey, Key, Nk, Nr);
+    return;
+  }
+#endif
+
   // The first round key is the key itself.
   for (i = 0; i < Nk; ++i)
   {
@@ -183,29 +227,14 @@ static void KeyExpansion(uint8_t* RoundKey, const uint8_t* Key)
         tempa[3] = u8tmp;
       }
 
-      // SubWord() is a function that takes a four-byte input word and
-      // applies the S-box to each of the four bytes to produce an output word.
-
-      // Function Subword()
-      {
-        tempa[0] = getSBoxValue(tempa[0]);
-        tempa[1] = getSBoxValue(tempa[1]);
-        tempa[2] = getSBoxValue(tempa[2]);
-        tempa[3] = getSBoxValue(tempa[3]);
-      }
+      SubWord(tempa);
 
       tempa[0] = tempa[0] ^ Rcon[i/Nk];
     }
 #if defined(AES256) && (AES256 == 1)
     if (i % Nk == 4)
     {
-      // Function Subword()
-      {
-        tempa[0] = getSBoxValue(tempa[0]);
-        tempa[1] = getSBoxValue(tempa[1]);
-        tempa[2] = getSBoxValue(tempa[2]);
-        tempa[3] = getSBoxValue(tempa[3]);
-      }
+      SubWord(tempa);
     }
 #endif
     j = i * 4; k=(i - Nk) * 4;
@@ -219,11 +248,17 @@ static void KeyExpansion(uint8_t* RoundKey, const uint8_t* Key)
 void AES_init_ctx(struct AES_ctx* ctx, const uint8_t* key)
 {
   KeyExpansion(ctx->RoundKey, key);
+#if defined(BITSLICE) && (BITSLICE == 1)
+  AES_BS_compress_key(ctx->BsRoundKey, ctx->RoundKey, Nr);
+#endif
 }
 #if (defined(CBC) && (CBC == 1)) || (defined(CTR) && (CTR == 1))
 void AES_init_ctx_iv(struct AES_ctx* ctx, const uint8_t* key, const uint8_t* iv)
 {
   KeyExpansion(ctx->RoundKey, key);
+#if defined(BITSLICE) && (BITSLICE == 1)
+  AES_BS_compress_key(ctx->BsRoundKey, ctx->RoundKey, Nr);
+#endif
   memcpy (ctx->Iv, iv, AES_BLOCKLEN);
 }
 void AES_ctx_set_iv(struct AES_ctx* ctx, const uint8_t* iv)
@@ -232,6 +267,238 @@ void AES_ctx_set_iv(struct AES_ctx* ctx, const uint8_t* iv)
 }
 #endif
 
+#if defined(UNROLLED) && (UNROLLED == 1)
+
+// Fully unrolled core. The state lives in four 32-bit words, one per column, with
+// row 0 in the low byte. Every round of the configured key size is written out by
+// the macros below, so there is no loop counter, no round test and no state_t in
+// memory between the steps.
+
+#define LOAD32(p)       ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+#define STORE32(p, w)   do { (p)[0] = (uint8_t)(w); (p)[1] = (uint8_t)((w) >> 8); (p)[2] = (uint8_t)((w) >> 16); (p)[3] = (uint8_t)((w) >> 24); } while (0)
+#define ROR32(w, n)     (((w) >> (n)) | ((w) << (32 - (n))))
+// xtime() on all four bytes of a word
+#define XTIME32(w)      ((((w) & 0x7f7f7f7fu) << 1) ^ ((((w) >> 7) & 0x01010101u) * 0x1b))
+
+// SubBytes and ShiftRows for one column: row r comes from column c+r
+#define SUB_SHIFT(c0, c1, c2, c3, box)              \
+  ((uint32_t)box[(c0) & 0xff]                     | \
+  ((uint32_t)box[((c1) >> 8) & 0xff] << 8)        | \
+  ((uint32_t)box[((c2) >> 16) & 0xff] << 16)      | \
+  ((uint32_t)box[(c3) >> 24] << 24))
+
+// 2*a[r] ^ 3*a[r+1] ^ a[r+2] ^ a[r+3] for all rows at once
+static uint32_t MixColumn32(uint32_t w)
+{
+  uint32_t t = w ^ ROR32(w, 8);
+  return XTIME32(t) ^ ROR32(w, 8) ^ ROR32(t, 16);
+}
+
+// One full round from the words i0..i3 into o0..o3, round key k
+#define ENC_ROUND(k, i, o)                                                                        \
+  o##0 = MixColumn32(SUB_SHIFT(i##0, i##1, i##2, i##3, sbox)) ^ LOAD32(RoundKey + 16 * (k));      \
+  o##1 = MixColumn32(SUB_SHIFT(i##1, i##2, i##3, i##0, sbox)) ^ LOAD32(RoundKey + 16 * (k) + 4);  \
+  o##2 = MixColumn32(SUB_SHIFT(i##2, i##3, i##0, i##1, sbox)) ^ LOAD32(RoundKey + 16 * (k) + 8);  \
+  o##3 = MixColumn32(SUB_SHIFT(i##3, i##0, i##1, i##2, sbox)) ^ LOAD32(RoundKey + 16 * (k) + 12)
+
+// Last round, without MixColumns(), round key k of the schedule rk
+#define ENC_LAST_KEY(rk, k, i, o)                                                                 \
+  o##0 = SUB_SHIFT(i##0, i##1, i##2, i##3, sbox) ^ LOAD32((rk) + 16 * (k));                       \
+  o##1 = SUB_SHIFT(i##1, i##2, i##3, i##0, sbox) ^ LOAD32((rk) + 16 * (k) + 4);                   \
+  o##2 = SUB_SHIFT(i##2, i##3, i##0, i##1, sbox) ^ LOAD32((rk) + 16 * (k) + 8);                   \
+  o##3 = SUB_SHIFT(i##3, i##0, i##1, i##2, sbox) ^ LOAD32((rk) + 16 * (k) + 12)
+
+#define ENC_LAST(k, i, o)   ENC_LAST_KEY(RoundKey, k, i, o)
+
+static void CipherRounds(state_t* state, const uint8_t* RoundKey)
+{
+  uint8_t* p = (uint8_t*)state;
+  uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+
+  s0 = LOAD32(p)      ^ LOAD32(RoundKey);
+  s1 = LOAD32(p + 4)  ^ LOAD32(RoundKey + 4);
+  s2 = LOAD32(p + 8)  ^ LOAD32(RoundKey + 8);
+  s3 = LOAD32(p + 12) ^ LOAD32(RoundKey + 12);
+
+  ENC_ROUND(1, s, t);  ENC_ROUND(2, t, s);
+  ENC_ROUND(3, s, t);  ENC_ROUND(4, t, s);
+  ENC_ROUND(5, s, t);  ENC_ROUND(6, t, s);
+  ENC_ROUND(7, s, t);  ENC_ROUND(8, t, s);
+  ENC_ROUND(9, s, t);
+#if Nr > 10
+  ENC_ROUND(10, t, s); ENC_ROUND(11, s, t);
+#endif
+#if Nr > 12
+  ENC_ROUND(12, t, s); ENC_ROUND(13, s, t);
+#endif
+  ENC_LAST(Nr, t, s);
+
+  STORE32(p, s0);
+  STORE32(p + 4, s1);
+  STORE32(p + 8, s2);
+  STORE32(p + 12, s3);
+}
+
+#if defined(CBC) && (CBC == 1) && !(defined(BITSLICE) && (BITSLICE == 1))
+// Number of independent blocks CipherLanes() encrypts per call
+#define MULTI_LANES 4
+
+// SubBytes and MixColumns of one byte in row 0: {2, 1, 1, 3} * sbox[x], row 0 in the
+// low byte. Row r of a column takes the entry rotated left by 8 * r, so one table
+// replaces SUB_SHIFT() and MixColumn32() in CipherLanes().
+static const uint32_t Te0[256] = {
+  0xa56363c6, 0x847c7cf8, 0x997777ee, 0x8d7b7bf6, 0x0df2f2ff, 0xbd6b6bd6, 0xb16f6fde, 0x54c5c591,
+  0x50303060, 0x03010102, 0xa96767ce, 0x7d2b2b56, 0x19fefee7, 0x62d7d7b5, 0xe6abab4d, 0x9a7676ec,
+  0x45caca8f, 0x9d82821f, 0x40c9c989, 0x877d7dfa, 0x15fafaef, 0xeb5959b2, 0xc947478e, 0x0bf0f0fb,
+  0xecadad41, 0x67d4d4b3, 0xfda2a25f, 0xeaafaf45, 0xbf9c9c23, 0xf7a4a453, 0x967272e4, 0x5bc0c09b,
+  0xc2b7b775, 0x1cfdfde1, 0xae93933d, 0x6a26264c, 0x5a36366c, 0x413f3f7e, 0x02f7f7f5, 0x4fcccc83,
+  0x5c343468, 0xf4a5a551, 0x34e5e5d1, 0x08f1f1f9, 0x937171e2, 0x73d8d8ab, 0x53313162, 0x3f15152a,
+  0x0c040408, 0x52c7c795, 0x65232346, 0x5ec3c39d, 0x28181830, 0xa1969637, 0x0f05050a, 0xb59a9a2f,
+  0x0907070e, 0x36121224, 0x9b80801b, 0x3de2e2df, 0x26ebebcd, 0x6927274e, 0xcdb2b27f, 0x9f7575ea,
+  0x1b090912, 0x9e83831d, 0x742c2c58, 0x2e1a1a34, 0x2d1b1b36, 0xb26e6edc, 0xee5a5ab4, 0xfba0a05b,
+  0xf65252a4, 0x4d3b3b76, 0x61d6d6b7, 0xceb3b37d, 0x7b292952, 0x3ee3e3dd, 0x712f2f5e, 0x97848413,
+  0xf55353a6, 0x68d1d1b9, 0x00000000, 0x2cededc1, 0x60202040, 0x1ffcfce3, 0xc8b1b179, 0xed5b5bb6,
+  0xbe6a6ad4, 0x46cbcb8d, 0xd9bebe67, 0x4b393972, 0xde4a4a94, 0xd44c4c98, 0xe85858b0, 0x4acfcf85,
+  0x6bd0d0bb, 0x2aefefc5, 0xe5aaaa4f, 0x16fbfbed, 0xc5434386, 0xd74d4d9a, 0x55333366, 0x94858511,
+  0xcf45458a, 0x10f9f9e9, 0x06020204, 0x817f7ffe, 0xf05050a0, 0x443c3c78, 0xba9f9f25, 0xe3a8a84b,
+  0xf35151a2, 0xfea3a35d, 0xc0404080, 0x8a8f8f05, 0xad92923f, 0xbc9d9d21, 0x48383870, 0x04f5f5f1,
+  0xdfbcbc63, 0xc1b6b677, 0x75dadaaf, 0x63212142, 0x30101020, 0x1affffe5, 0x0ef3f3fd, 0x6dd2d2bf,
+  0x4ccdcd81, 0x140c0c18, 0x35131326, 0x2fececc3, 0xe15f5fbe, 0xa2979735, 0xcc444488, 0x3917172e,
+  0x57c4c493, 0xf2a7a755, 0x827e7efc, 0x473d3d7a, 0xac6464c8, 0xe75d5dba, 0x2b191932, 0x957373e6,
+  0xa06060c0, 0x98818119, 0xd14f4f9e, 0x7fdcdca3, 0x66222244, 0x7e2a2a54, 0xab90903b, 0x8388880b,
+  0xca46468c, 0x29eeeec7, 0xd3b8b86b, 0x3c141428, 0x79dedea7, 0xe25e5ebc, 0x1d0b0b16, 0x76dbdbad,
+  0x3be0e0db, 0x56323264, 0x4e3a3a74, 0x1e0a0a14, 0xdb494992, 0x0a06060c, 0x6c242448, 0xe45c5cb8,
+  0x5dc2c29f, 0x6ed3d3bd, 0xefacac43, 0xa66262c4, 0xa8919139, 0xa4959531, 0x37e4e4d3, 0x8b7979f2,
+  0x32e7e7d5, 0x43c8c88b, 0x5937376e, 0xb76d6dda, 0x8c8d8d01, 0x64d5d5b1, 0xd24e4e9c, 0xe0a9a949,
+  0xb46c6cd8, 0xfa5656ac, 0x07f4f4f3, 0x25eaeacf, 0xaf6565ca, 0x8e7a7af4, 0xe9aeae47, 0x18080810,
+  0xd5baba6f, 0x887878f0, 0x6f25254a, 0x722e2e5c, 0x241c1c38, 0xf1a6a657, 0xc7b4b473, 0x51c6c697,
+  0x23e8e8cb, 0x7cdddda1, 0x9c7474e8, 0x211f1f3e, 0xdd4b4b96, 0xdcbdbd61, 0x868b8b0d, 0x858a8a0f,
+  0x907070e0, 0x423e3e7c, 0xc4b5b571, 0xaa6666cc, 0xd8484890, 0x05030306, 0x01f6f6f7, 0x120e0e1c,
+  0xa36161c2, 0x5f35356a, 0xf95757ae, 0xd0b9b969, 0x91868617, 0x58c1c199, 0x271d1d3a, 0xb99e9e27,
+  0x38e1e1d9, 0x13f8f8eb, 0xb398982b, 0x33111122, 0xbb6969d2, 0x70d9d9a9, 0x898e8e07, 0xa7949433,
+  0xb69b9b2d, 0x221e1e3c, 0x92878715, 0x20e9e9c9, 0x49cece87, 0xff5555aa, 0x78282850, 0x7adfdfa5,
+  0x8f8c8c03, 0xf8a1a159, 0x80898909, 0x170d0d1a, 0xdabfbf65, 0x31e6e6d7, 0xc6424284, 0xb86868d0,
+  0xc3414182, 0xb0999929, 0x772d2d5a, 0x110f0f1e, 0xcbb0b07b, 0xfc5454a8, 0xd6bbbb6d, 0x3a16162c };
+
+// SubBytes, ShiftRows and MixColumns for one column with Te0
+#define TE_COLUMN(c0, c1, c2, c3)                   \
+  (Te0[(c0) & 0xff]                               ^ \
+  ROR32(Te0[((c1) >> 8) & 0xff], 24)              ^ \
+  ROR32(Te0[((c2) >> 16) & 0xff], 16)             ^ \
+  ROR32(Te0[(c3) >> 24], 8))
+
+#define TE_ROUND_KEY(rk, k, i, o)                                                                 \
+  o##0 = TE_COLUMN(i##0, i##1, i##2, i##3) ^ LOAD32((rk) + 16 * (k));                             \
+  o##1 = TE_COLUMN(i##1, i##2, i##3, i##0) ^ LOAD32((rk) + 16 * (k) + 4);                         \
+  o##2 = TE_COLUMN(i##2, i##3, i##0, i##1) ^ LOAD32((rk) + 16 * (k) + 8);                         \
+  o##3 = TE_COLUMN(i##3, i##0, i##1, i##2) ^ LOAD32((rk) + 16 * (k) + 12)
+
+// The same round for the four lanes a..d, lane l with the key schedule keys[l]
+#define LANE_ROUND(k, i, o)                                                                       \
+  TE_ROUND_KEY(keys[0], k, i##a, o##a); TE_ROUND_KEY(keys[1], k, i##b, o##b);                     \
+  TE_ROUND_KEY(keys[2], k, i##c, o##c); TE_ROUND_KEY(keys[3], k, i##d, o##d)
+
+#define LANE_LAST(k, i, o)                                                                        \
+  ENC_LAST_KEY(keys[0], k, i##a, o##a); ENC_LAST_KEY(keys[1], k, i##b, o##b);                     \
+  ENC_LAST_KEY(keys[2], k, i##c, o##c); ENC_LAST_KEY(keys[3], k, i##d, o##d)
+
+#define LANE_LOAD(l, n)                                                                           \
+  s##l##0 = LOAD32(blocks + 16 * (n))      ^ LOAD32(keys[n]);                                     \
+  s##l##1 = LOAD32(blocks + 16 * (n) + 4)  ^ LOAD32(keys[n] + 4);                                 \
+  s##l##2 = LOAD32(blocks + 16 * (n) + 8)  ^ LOAD32(keys[n] + 8);                                 \
+  s##l##3 = LOAD32(blocks + 16 * (n) + 12) ^ LOAD32(keys[n] + 12)
+
+#define LANE_STORE(l, n)                                                                          \
+  STORE32(blocks + 16 * (n), s##l##0);                                                            \
+  STORE32(blocks + 16 * (n) + 4, s##l##1);                                                        \
+  STORE32(blocks + 16 * (n) + 8, s##l##2);                                                        \
+  STORE32(blocks + 16 * (n) + 12, s##l##3)
+
+// Encrypts the MULTI_LANES consecutive blocks at blocks, block l with the round keys
+// keys[l]. The lanes share no data, so the table lookups of one lane fill the
+// pipeline while another waits for its loads; a single CBC chain cannot do that
+// because every block needs the previous one.
+static void CipherLanes(uint8_t* blocks, const uint8_t* const keys[MULTI_LANES])
+{
+  uint32_t sa0, sa1, sa2, sa3, sb0, sb1, sb2, sb3, sc0, sc1, sc2, sc3, sd0, sd1, sd2, sd3;
+  uint32_t ta0, ta1, ta2, ta3, tb0, tb1, tb2, tb3, tc0, tc1, tc2, tc3, td0, td1, td2, td3;
+
+  LANE_LOAD(a, 0); LANE_LOAD(b, 1); LANE_LOAD(c, 2); LANE_LOAD(d, 3);
+
+  LANE_ROUND(1, s, t);  LANE_ROUND(2, t, s);
+  LANE_ROUND(3, s, t);  LANE_ROUND(4, t, s);
+  LANE_ROUND(5, s, t);  LANE_ROUND(6, t, s);
+  LANE_ROUND(7, s, t);  LANE_ROUND(8, t, s);
+  LANE_ROUND(9, s, t);
+#if Nr > 10
+  LANE_ROUND(10, t, s); LANE_ROUND(11, s, t);
+#endif
+#if Nr > 12
+  LANE_ROUND(12, t, s); LANE_ROUND(13, s, t);
+#endif
+  LANE_LAST(Nr, t, s);
+
+  LANE_STORE(a, 0); LANE_STORE(b, 1); LANE_STORE(c, 2); LANE_STORE(d, 3);
+}
+#endif // #if defined(CBC) && (CBC == 1) && !(defined(BITSLICE) && (BITSLICE == 1))
+
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
+// InvShiftRows and InvSubBytes for one column: row r comes from column c-r
+#define INV_SUB_SHIFT(c0, c1, c2, c3)  SUB_SHIFT(c0, c1, c2, c3, rsbox)
+
+// 14*a[r] ^ 11*a[r+1] ^ 13*a[r+2] ^ 9*a[r+3]: multiply rows r and r+2 by 4 and
+// add them to each other, then MixColumns
+static uint32_t InvMixColumn32(uint32_t w)
+{
+  uint32_t u = XTIME32(XTIME32(w ^ ROR32(w, 16)));
+  return MixColumn32(w ^ u);
+}
+
+#define DEC_ROUND(k, i, o)                                                                        \
+  o##0 = InvMixColumn32(INV_SUB_SHIFT(i##0, i##3, i##2, i##1) ^ LOAD32(RoundKey + 16 * (k)));     \
+  o##1 = InvMixColumn32(INV_SUB_SHIFT(i##1, i##0, i##3, i##2) ^ LOAD32(RoundKey + 16 * (k) + 4)); \
+  o##2 = InvMixColumn32(INV_SUB_SHIFT(i##2, i##1, i##0, i##3) ^ LOAD32(RoundKey + 16 * (k) + 8)); \
+  o##3 = InvMixColumn32(INV_SUB_SHIFT(i##3, i##2, i##1, i##0) ^ LOAD32(RoundKey + 16 * (k) + 12))
+
+// Last round, without InvMixColumns()
+#define DEC_LAST(k, i, o)                                                                         \
+  o##0 = INV_SUB_SHIFT(i##0, i##3, i##2, i##1) ^ LOAD32(RoundKey + 16 * (k));                     \
+  o##1 = INV_SUB_SHIFT(i##1, i##0, i##3, i##2) ^ LOAD32(RoundKey + 16 * (k) + 4);                 \
+  o##2 = INV_SUB_SHIFT(i##2, i##1, i##0, i##3) ^ LOAD32(RoundKey + 16 * (k) + 8);                 \
+  o##3 = INV_SUB_SHIFT(i##3, i##2, i##1, i##0) ^ LOAD32(RoundKey + 16 * (k) + 12)
+
+static void InvCipherRounds(state_t* state, const uint8_t* RoundKey)
+{
+  uint8_t* p = (uint8_t*)state;
+  uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+
+  s0 = LOAD32(p)      ^ LOAD32(RoundKey + 16 * Nr);
+  s1 = LOAD32(p + 4)  ^ LOAD32(RoundKey + 16 * Nr + 4);
+  s2 = LOAD32(p + 8)  ^ LOAD32(RoundKey + 16 * Nr + 8);
+  s3 = LOAD32(p + 12) ^ LOAD32(RoundKey + 16 * Nr + 12);
+
+#if Nr > 12
+  DEC_ROUND(13, s, t); DEC_ROUND(12, t, s);
+#endif
+#if Nr > 10
+  DEC_ROUND(11, s, t); DEC_ROUND(10, t, s);
+#endif
+  DEC_ROUND(9, s, t);  DEC_ROUND(8, t, s);
+  DEC_ROUND(7, s, t);  DEC_ROUND(6, t, s);
+  DEC_ROUND(5, s, t);  DEC_ROUND(4, t, s);
+  DEC_ROUND(3, s, t);  DEC_ROUND(2, t, s);
+  DEC_ROUND(1, s, t);
+  DEC_LAST(0, t, s);
+
+  STORE32(p, s0);
+  STORE32(p + 4, s1);
+  STORE32(p + 8, s2);
+  STORE32(p + 12, s3);
+}
+#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
+
+#else // readable core, one function per step
+
 // This function adds the round key to state.
 // The round key is added to the state by an XOR function.
 static void AddRoundKey(uint8_t round, state_t* state, const uint8_t* RoundKey)
@@ -335,7 +602,7 @@ static uint8_t Multiply(uint8_t x, uint8_t y)
 
 #endif
 
-#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
 /*
 static uint8_t getSBoxInvert(uint8_t num)
 {
@@ -407,10 +674,10 @@ static void InvShiftRows(state_t* state)
   (*state)[2][3] = (*state)[3][3];
   (*state)[3][3] = temp;
 }
-#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
 
-// Cipher is the main function that encrypts the PlainText.
-static void Cipher(state_t* state, const uint8_t* RoundKey)
+// CipherRounds() runs all rounds of the encryption on the state.
+static void CipherRounds(state_t* state, const uint8_t* RoundKey)
 {
   uint8_t round = 0;
 
@@ -435,8 +702,9 @@ static void Cipher(state_t* state, const uint8_t* RoundKey)
   AddRoundKey(Nr, state, RoundKey);
 }
 
-#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
-static void InvCipher(state_t* state, const uint8_t* RoundKey)
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
+// InvCipherRounds() runs all rounds of the decryption on the state.
+static void InvCipherRounds(state_t* state, const uint8_t* RoundKey)
 {
   uint8_t round = 0;
 
@@ -457,9 +725,68 @@ static void InvCipher(state_t* state, const uint8_t* RoundKey)
     }
     InvMixColumns(state);
   }
+}
+#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
+
+#endif // #if defined(UNROLLED) && (UNROLLED == 1)
+
+// Cipher and InvCipher take the expanded key and, with BITSLICE, its compressed form:
+// BS_KEY(ctx, RoundKey) is ctx->BsRoundKey then, NULL otherwise.
+#if defined(BITSLICE) && (BITSLICE == 1)
+#define BS_KEY(ctx, key) ((ctx)->Bs##key)
+#else
+#define BS_KEY(ctx, key) NULL
+#endif
+
+// Cipher is the main function that encrypts the PlainText.
+static void Cipher(state_t* state, const uint8_t* RoundKey, const uint64_t* BsRoundKey)
+{
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  if (AES_NEON_available())
+  {
+    AES_NEON_encrypt_blocks(RoundKey, Nr, (uint8_t*)state, 1);
+    return;
+  }
+#endif
+#if defined(BITSLICE) && (BITSLICE == 1)
+  // a single block takes a whole kernel call, the other positions are padding
+  {
+    uint8_t blocks[AES_BS_BLOCKS * AES_BLOCKLEN] = { 0 };
+    memcpy(blocks, state, AES_BLOCKLEN);
+    AES_BS_encrypt8(BsRoundKey, Nr, blocks);
+    memcpy(state, blocks, AES_BLOCKLEN);
+    return;
+  }
+#else
+  (void)BsRoundKey;
+#endif
+  CipherRounds(state, RoundKey);
+}
 
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
+static void InvCipher(state_t* state, const uint8_t* RoundKey, const uint64_t* BsRoundKey)
+{
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  if (AES_NEON_available())
+  {
+    AES_NEON_decrypt_blocks(RoundKey, Nr, (uint8_t*)state, 1);
+    return;
+  }
+#endif
+#if defined(BITSLICE) && (BITSLICE == 1)
+  {
+    uint8_t blocks[AES_BS_BLOCKS * AES_BLOCKLEN] = { 0 };
+    memcpy(blocks, state, AES_BLOCKLEN);
+    AES_BS_decrypt8(BsRoundKey, Nr, blocks);
+    memcpy(state, blocks, AES_BLOCKLEN);
+    return;
+  }
+#else
+  (void)BsRoundKey;
+#endif
+  InvCipherRounds(state, RoundKey);
 }
-#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1) || (defined(XTS) && XTS == 1)
 
 /*****************************************************************************/
 /* Public functions:                                                         */
@@ -470,13 +797,13 @@ static void InvCipher(state_t* state, const uint8_t* RoundKey)
 void AES_ECB_encrypt(const struct AES_ctx* ctx, uint8_t* buf)
 {
   // The next function call encrypts the PlainText with the Key using AES algorithm.
-  Cipher((state_t*)buf, ctx->RoundKey);
+  Cipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
 }
 
 void AES_ECB_decrypt(const struct AES_ctx* ctx, uint8_t* buf)
 {
   // The next function call decrypts the PlainText with the Key using AES algorithm.
-  InvCipher((state_t*)buf, ctx->RoundKey);
+  InvCipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
 }
 
 
@@ -486,9 +813,7 @@ void AES_ECB_decrypt(const struct AES_ctx* ctx, uint8_t* buf)
 
 
 
-#if defined(CBC) && (CBC == 1)
-
-
+#if (defined(CBC) && (CBC == 1)) || (defined(XTS) && (XTS == 1))
 static void XorWithIv(uint8_t* buf, const uint8_t* Iv)
 {
   uint8_t i;
@@ -497,15 +822,26 @@ static void XorWithIv(uint8_t* buf, const uint8_t* Iv)
     buf[i] ^= Iv[i];
   }
 }
+#endif
+
+#if defined(CBC) && (CBC == 1)
+
 
 void AES_CBC_encrypt_buffer(struct AES_ctx *ctx, uint8_t* buf, size_t length)
 {
   size_t i;
   uint8_t *Iv = ctx->Iv;
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  if (AES_NEON_available())
+  {
+    AES_NEON_cbc_encrypt(ctx->RoundKey, Nr, ctx->Iv, buf, length / AES_BLOCKLEN);
+    return;
+  }
+#endif
   for (i = 0; i < length; i += AES_BLOCKLEN)
   {
     XorWithIv(buf, Iv);
-    Cipher((state_t*)buf, ctx->RoundKey);
+    Cipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
     Iv = buf;
     buf += AES_BLOCKLEN;
   }
@@ -513,18 +849,216 @@ void AES_CBC_encrypt_buffer(struct AES_ctx *ctx, uint8_t* buf, size_t length)
   memcpy(ctx->Iv, Iv, AES_BLOCKLEN);
 }
 
+#if (defined(UNROLLED) && (UNROLLED == 1)) || (defined(BITSLICE) && (BITSLICE == 1))
+
+// Messages sorted and scheduled together by AES_CBC_encrypt_multi()
+#define MULTI_BATCH 64
+
+#if defined(BITSLICE) && (BITSLICE == 1)
+// Lane kernel: the bitsliced 8-block kernel with one merged key per block position
+typedef uint64_t lane_keys_t[AES_BS_MERGED_WORDS(Nr)];
+#define LANES AES_BS_BLOCKS
+#define MULTI_MIN_LANES 4
+#define LaneSetKey(keys, lane, ctx)  AES_BS_set_lane_key((keys), (lane), (ctx)->BsRoundKey, Nr)
+#define LanesEncrypt(keys, blocks)   AES_BS_encrypt8_merged((keys), Nr, (blocks))
+#else
+// Lane kernel: the interleaved column-word core, one key schedule pointer per lane.
+// Below MULTI_MIN_LANES busy lanes the serial core is as fast.
+typedef const uint8_t* lane_keys_t[MULTI_LANES];
+#define LANES MULTI_LANES
+#define MULTI_MIN_LANES 2
+#define LaneSetKey(keys, lane, ctx)  ((keys)[lane] = (ctx)->RoundKey)
+#define LanesEncrypt(keys, blocks)   CipherLanes((blocks), (keys))
+#endif
+
+/* Run the messages order[0..count) through the LANES lanes of the kernel. A lane
+   takes the next message as soon as its current one is done, so with the longest
+   messages first the lanes stay busy until the last few messages. */
+static void CbcEncryptLanes(struct AES_ctx* ctxs[], uint8_t* bufs[], const size_t lens[],
+                            const uint8_t* order, size_t count)
+{
+  uint8_t blocks[LANES * AES_BLOCKLEN];
+  lane_keys_t keys;
+  size_t stream[LANES];
+  size_t offset[LANES];
+  uint8_t active[LANES];
+  size_t next = 0;
+  unsigned busy = 0;
+  unsigned lane;
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  /* idle lanes compute throw-away blocks, any key will do */
+  for (lane = 0; lane < LANES; ++lane)
+  {
+    LaneSetKey(keys, lane, ctxs[order[0]]);
+  }
+  memset(blocks, 0, sizeof(blocks));
+  memset(active, 0, sizeof(active));
+
+  for (lane = 0; lane < LANES; ++lane)
+  {
+    while ((next < count) && (lens[order[next]] == 0))
+    {
+      ++next;
+    }
+    if (next < count)
+    {
+      stream[lane] = order[next++];
+      offset[lane] = 0;
+      active[lane] = 1;
+      LaneSetKey(keys, lane, ctxs[stream[lane]]);
+      ++busy;
+    }
+  }
+
+  while ((busy >= MULTI_MIN_LANES) || ((busy > 0) && (next < count)))
+  {
+    for (lane = 0; lane < LANES; ++lane)
+    {
+      if (active[lane])
+      {
+        memcpy(blocks + lane * AES_BLOCKLEN, bufs[stream[lane]] + offset[lane], AES_BLOCKLEN);
+        XorWithIv(blocks + lane * AES_BLOCKLEN, ctxs[stream[lane]]->Iv);
+      }
+    }
+
+    LanesEncrypt(keys, blocks);
+
+    for (lane = 0; lane < LANES; ++lane)
+    {
+      if (!active[lane])
+      {
+        continue;
+      }
+      memcpy(bufs[stream[lane]] + offset[lane], blocks + lane * AES_BLOCKLEN, AES_BLOCKLEN);
+      memcpy(ctxs[stream[lane]]->Iv, blocks + lane * AES_BLOCKLEN, AES_BLOCKLEN);
+      offset[lane] += AES_BLOCKLEN;
+      if (offset[lane] < lens[stream[lane]])
+      {
+        continue;
+      }
+      /* message done, refill the lane */
+      while ((next < count) && (lens[order[next]] == 0))
+      {
+        ++next;
+      }
+      if (next < count)
+      {
+        stream[lane] = order[next++];
+        offset[lane] = 0;
+        LaneSetKey(keys, lane, ctxs[stream[lane]]);
+      }
+      else
+      {
+        active[lane] = 0;
+        --busy;
+      }
+    }
+  }
+
+  /* the few messages left finish on the serial core */
+  for (lane = 0; lane < LANES; ++lane)
+  {
+    if (active[lane])
+    {
+      AES_CBC_encrypt_buffer(ctxs[stream[lane]], bufs[stream[lane]] + offset[lane],
+                             lens[stream[lane]] - offset[lane]);
+    }
+  }
+}
+
+void AES_CBC_encrypt_multi(struct AES_ctx* ctxs[], uint8_t* bufs[], const size_t lens[], size_t n)
+{
+  uint8_t order[MULTI_BATCH];
+  size_t base, count, i, j;
+
+#if !(defined(BITSLICE) && (BITSLICE == 1)) && defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  /* the interleaved core uses the tables, keep the constant-time permute path */
+  if (AES_NEON_available())
+  {
+    for (i = 0; i < n; ++i)
+    {
+      AES_CBC_encrypt_buffer(ctxs[i], bufs[i], lens[i]);
+    }
+    return;
+  }
+#endif
+
+  for (base = 0; base < n; base += count)
+  {
+    count = ((n - base) < MULTI_BATCH) ? (n - base) : MULTI_BATCH;
+
+    /* group by length: longest first, insertion sort on the batch */
+    for (i = 0; i < count; ++i)
+    {
+      uint8_t idx = (uint8_t)i;
+      for (j = i; (j > 0) && (lens[base + order[j - 1]] < lens[base + idx]); --j)
+      {
+        order[j] = order[j - 1];
+      }
+      order[j] = idx;
+    }
+    CbcEncryptLanes(ctxs + base, bufs + base, lens + base, order, count);
+  }
+}
+
+#else
+
+void AES_CBC_encrypt_multi(struct AES_ctx* ctxs[], uint8_t* bufs[], const size_t lens[], size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; ++i)
+  {
+    AES_CBC_encrypt_buffer(ctxs[i], bufs[i], lens[i]);
+  }
+}
+
+#endif // #if (defined(UNROLLED) && (UNROLLED == 1)) || (defined(BITSLICE) && (BITSLICE == 1))
+
 void AES_CBC_decrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length)
 {
   size_t i;
   uint8_t storeNextIv[AES_BLOCKLEN];
+#if defined(BITSLICE) && (BITSLICE == 1)
+  /* 8 blocks per kernel call, a shorter tail is padded to a full call */
+  uint8_t blocks[AES_BS_BLOCKS * AES_BLOCKLEN] = { 0 };
+  size_t n;
+  for (; length >= AES_BLOCKLEN; length -= n)
+  {
+    n = (length < sizeof(blocks)) ? (length - length % AES_BLOCKLEN) : sizeof(blocks);
+    memcpy(blocks, buf, n);
+    AES_BS_decrypt8(ctx->BsRoundKey, Nr, blocks);
+    memcpy(storeNextIv, buf + n - AES_BLOCKLEN, AES_BLOCKLEN);
+    XorWithIv(blocks, ctx->Iv);
+    for (i = AES_BLOCKLEN; i < n; i += AES_BLOCKLEN)
+    {
+      XorWithIv(blocks + i, buf + i - AES_BLOCKLEN);
+    }
+    memcpy(buf, blocks, n);
+    memcpy(ctx->Iv, storeNextIv, AES_BLOCKLEN);
+    buf += n;
+  }
+#else
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  if (AES_NEON_available())
+  {
+    AES_NEON_cbc_decrypt(ctx->RoundKey, Nr, ctx->Iv, buf, length / AES_BLOCKLEN);
+    return;
+  }
+#endif
   for (i = 0; i < length; i += AES_BLOCKLEN)
   {
     memcpy(storeNextIv, buf, AES_BLOCKLEN);
-    InvCipher((state_t*)buf, ctx->RoundKey);
+    InvCipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
     XorWithIv(buf, ctx->Iv);
     memcpy(ctx->Iv, storeNextIv, AES_BLOCKLEN);
     buf += AES_BLOCKLEN;
   }
+#endif
 
 }
 
@@ -534,38 +1068,452 @@ void AES_CBC_decrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length)
 
 #if defined(CTR) && (CTR == 1)
 
+/* Increment Iv and handle overflow */
+static void IncrementIv(uint8_t* Iv)
+{
+  int bi;
+  for (bi = (AES_BLOCKLEN - 1); bi >= 0; --bi)
+  {
+    /* inc will overflow */
+    if (Iv[bi] == 255)
+    {
+      Iv[bi] = 0;
+      continue;
+    }
+    Iv[bi] += 1;
+    break;
+  }
+}
+
 /* Symmetrical operation: same function for encrypting as for decrypting. Note any IV/nonce should never be reused with the same key */
 void AES_CTR_xcrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length)
 {
-  uint8_t buffer[AES_BLOCKLEN];
-
   size_t i;
+#if defined(BITSLICE) && (BITSLICE == 1)
+  /* 8 counter blocks per kernel call, a shorter tail is padded to a full call */
+  uint8_t keystream[AES_BS_BLOCKS * AES_BLOCKLEN] = { 0 };
+  size_t n;
+  for (; length > 0; length -= n)
+  {
+    n = (length < sizeof(keystream)) ? length : sizeof(keystream);
+    for (i = 0; i < n; i += AES_BLOCKLEN)
+    {
+      memcpy(keystream + i, ctx->Iv, AES_BLOCKLEN);
+      IncrementIv(ctx->Iv);
+    }
+    AES_BS_encrypt8(ctx->BsRoundKey, Nr, keystream);
+    for (i = 0; i < n; ++i)
+    {
+      buf[i] ^= keystream[i];
+    }
+    buf += n;
+  }
+#else
+  uint8_t buffer[AES_BLOCKLEN];
   int bi;
+
+#if defined(NEON_PERMUTE) && (NEON_PERMUTE == 1)
+  if (AES_NEON_available())
+  {
+    /* 8 counter blocks per call, the tail rounded up to whole blocks */
+    uint8_t keystream[8 * AES_BLOCKLEN];
+    size_t n;
+    for (; length > 0; length -= n)
+    {
+      n = (length < sizeof(keystream)) ? length : sizeof(keystream);
+      for (i = 0; i < n; i += AES_BLOCKLEN)
+      {
+        memcpy(keystream + i, ctx->Iv, AES_BLOCKLEN);
+        IncrementIv(ctx->Iv);
+      }
+      AES_NEON_encrypt_blocks(ctx->RoundKey, Nr, keystream, (n + AES_BLOCKLEN - 1) / AES_BLOCKLEN);
+      for (i = 0; i < n; ++i)
+      {
+        buf[i] ^= keystream[i];
+      }
+      buf += n;
+    }
+    return;
+  }
+#endif
   for (i = 0, bi = AES_BLOCKLEN; i < length; ++i, ++bi)
   {
     if (bi == AES_BLOCKLEN) /* we need to regen xor compliment in buffer */
     {
 
       memcpy(buffer, ctx->Iv, AES_BLOCKLEN);
-      Cipher((state_t*)buffer,ctx->RoundKey);
+      Cipher((state_t*)buffer,ctx->RoundKey, BS_KEY(ctx, RoundKey));
+      IncrementIv(ctx->Iv);
+      bi = 0;
+    }
+
+    buf[i] = (buf[i] ^ buffer[bi]);
+  }
+#endif
+}
+
+#endif // #if defined(CTR) && (CTR == 1)
+
+
+
+#if defined(XTS) && (XTS == 1)
+
+/* Multiply the tweak by x in GF(2^128), little-endian byte order as in IEEE 1619 */
+static void XtsMultiplyAlpha(uint8_t* T)
+{
+  uint8_t i;
+  uint8_t carry = 0;
+  for (i = 0; i < AES_BLOCKLEN; ++i)
+  {
+    uint8_t next = T[i] >> 7;
+    T[i] = (uint8_t)((T[i] << 1) | carry);
+    carry = next;
+  }
+  T[0] ^= (uint8_t)(0x87 & -carry);
+}
+
+/* One block in the XEX construction: C = E_K1(P ^ T) ^ T, or the inverse */
+static void XtsBlock(const struct AES_xts_ctx* ctx, uint8_t* buf, const uint8_t* T, int decrypt)
+{
+  XorWithIv(buf, T);
+  if (decrypt)
+  {
+    InvCipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+  }
+  else
+  {
+    Cipher((state_t*)buf, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+  }
+  XorWithIv(buf, T);
+}
+
+static int XtsCryptSector(const struct AES_xts_ctx* ctx, uint64_t sector, uint8_t* buf, size_t length, int decrypt)
+{
+  uint8_t T[AES_BLOCKLEN];
+  uint8_t Tnext[AES_BLOCKLEN];
+  uint8_t stolen[AES_BLOCKLEN];
+  size_t tail = length % AES_BLOCKLEN;
+  size_t full = length / AES_BLOCKLEN;
+  size_t i;
+
+  if (length < AES_BLOCKLEN)
+  {
+    return -1;
+  }
+
+  /* T = E_K2(sector number as 128-bit little-endian value) */
+  for (i = 0; i < AES_BLOCKLEN; ++i)
+  {
+    T[i] = (i < sizeof(sector)) ? (uint8_t)(sector >> (8 * i)) : 0;
+  }
+  Cipher((state_t*)T, ctx->TweakKey, BS_KEY(ctx, TweakKey));
+
+  /* with a partial tail the last full block takes part in ciphertext stealing */
+  if (tail != 0)
+  {
+    --full;
+  }
+  for (i = 0; i < full; ++i)
+  {
+    XtsBlock(ctx, buf, T, decrypt);
+    XtsMultiplyAlpha(T);
+    buf += AES_BLOCKLEN;
+  }
+  if (tail == 0)
+  {
+    return 0;
+  }
+
+  /* buf points to the last full block, buf + AES_BLOCKLEN to the tail. The
+     stolen block is processed with the tweak following the last full block. */
+  memcpy(Tnext, T, AES_BLOCKLEN);
+  XtsMultiplyAlpha(Tnext);
+  XtsBlock(ctx, buf, decrypt ? Tnext : T, decrypt);
+  memcpy(stolen, buf, AES_BLOCKLEN);
+  memcpy(stolen, buf + AES_BLOCKLEN, tail);
+  memcpy(buf + AES_BLOCKLEN, buf, tail);
+  memcpy(buf, stolen, AES_BLOCKLEN);
+  XtsBlock(ctx, buf, decrypt ? T : Tnext, decrypt);
+  return 0;
+}
+
+void AES_XTS_init_ctx(struct AES_xts_ctx* ctx, const uint8_t* key1, const uint8_t* key2)
+{
+  KeyExpansion(ctx->RoundKey, key1);
+  KeyExpansion(ctx->TweakKey, key2);
+#if defined(BITSLICE) && (BITSLICE == 1)
+  AES_BS_compress_key(ctx->BsRoundKey, ctx->RoundKey, Nr);
+  AES_BS_compress_key(ctx->BsTweakKey, ctx->TweakKey, Nr);
+#endif
+}
+
+int AES_XTS_encrypt_sector(const struct AES_xts_ctx* ctx, uint64_t sector, uint8_t* buf, size_t length)
+{
+  return XtsCryptSector(ctx, sector, buf, length, 0);
+}
+
+int AES_XTS_decrypt_sector(const struct AES_xts_ctx* ctx, uint64_t sector, uint8_t* buf, size_t length)
+{
+  return XtsCryptSector(ctx, sector, buf, length, 1);
+}
+
+#endif // #if defined(XTS) && (XTS == 1)
+
+
+
+#if defined(CMAC) && (CMAC == 1)
+
+/* Multiply by x in GF(2^128), big-endian byte order as in SP 800-38B */
+static void CmacDouble(uint8_t* b)
+{
+  uint8_t i;
+  uint8_t msb = b[0] >> 7;
+  for (i = 0; i < (AES_BLOCKLEN - 1); ++i)
+  {
+    b[i] = (uint8_t)((b[i] << 1) | (b[i + 1] >> 7));
+  }
+  b[AES_BLOCKLEN - 1] = (uint8_t)((b[AES_BLOCKLEN - 1] << 1) ^ (0x87 & -msb));
+}
+
+void AES_CMAC(const struct AES_ctx* ctx, const uint8_t* msg, size_t length, uint8_t* mac)
+{
+  uint8_t subkey[AES_BLOCKLEN];
+  size_t i;
+  size_t last;
+
+  /* K1 = 2 * E_K(0), K2 = 4 * E_K(0) */
+  memset(subkey, 0, AES_BLOCKLEN);
+  Cipher((state_t*)subkey, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+  CmacDouble(subkey);
+
+  /* all blocks but the last one are plain CBC-MAC */
+  last = (length == 0) ? 0 : ((length - 1) / AES_BLOCKLEN) * AES_BLOCKLEN;
+  memset(mac, 0, AES_BLOCKLEN);
+  for (i = 0; i < last; ++i)
+  {
+    mac[i % AES_BLOCKLEN] ^= msg[i];
+    if ((i % AES_BLOCKLEN) == (AES_BLOCKLEN - 1))
+    {
+      Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+    }
+  }
+
+  /* a complete last block is masked with K1, a padded one with K2 */
+  for (i = last; i < length; ++i)
+  {
+    mac[i - last] ^= msg[i];
+  }
+  if ((length - last) != AES_BLOCKLEN)
+  {
+    mac[length - last] ^= 0x80;
+    CmacDouble(subkey);
+  }
+  for (i = 0; i < AES_BLOCKLEN; ++i)
+  {
+    mac[i] ^= subkey[i];
+  }
+  Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+}
+
+#endif // #if defined(CMAC) && (CMAC == 1)
+
+
+
+#if defined(CCM) && (CCM == 1)
+
+/* Write value big-endian into the last n bytes of a block */
+static void CcmPutLength(uint8_t* block, size_t n, uint64_t value)
+{
+  size_t i;
+  for (i = 0; i < n; ++i)
+  {
+    block[AES_BLOCKLEN - 1 - i] = (i < sizeof(value)) ? (uint8_t)(value >> (8 * i)) : 0;
+  }
+}
+
+/* B0 and the CBC-MAC over the encoded associated data, the result is left in mac */
+static int CcmStart(const struct AES_ctx* ctx, const uint8_t* nonce, size_t nonce_len,
+                    const uint8_t* aad, size_t aad_len, size_t length, size_t tag_len,
+                    uint8_t* mac, uint8_t* counter)
+{
+  const size_t L = 15 - nonce_len;
+  uint8_t header[10];
+  size_t header_len;
+  size_t i, pos;
+
+  if ((nonce_len < 7) || (nonce_len > 13) || (tag_len < 4) || (tag_len > 16) || (tag_len & 1))
+  {
+    return -1;
+  }
+  if ((L < sizeof(uint64_t)) && ((uint64_t)length >> (8 * L)) != 0)
+  {
+    return -1;
+  }
+
+  /* B0 = flags | nonce | message length */
+  mac[0] = (uint8_t)(((aad_len > 0) ? 0x40 : 0) | (((tag_len - 2) / 2) << 3) | (L - 1));
+  memcpy(mac + 1, nonce, nonce_len);
+  CcmPutLength(mac, L, length);
+  Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+
+  /* A0 = flags | nonce | 0, the counter of the first data block is 1 */
+  memset(counter, 0, AES_BLOCKLEN);
+  counter[0] = (uint8_t)(L - 1);
+  memcpy(counter + 1, nonce, nonce_len);
+
+  if (aad_len == 0)
+  {
+    return 0;
+  }
 
-      /* Increment Iv and handle overflow */
-      for (bi = (AES_BLOCKLEN - 1); bi >= 0; --bi)
+  /* length prefix of the associated data */
+  if (aad_len < 0xff00)
+  {
+    header[0] = (uint8_t)(aad_len >> 8);
+    header[1] = (uint8_t)aad_len;
+    header_len = 2;
+  }
+  else if ((uint64_t)aad_len <= 0xffffffffu)
+  {
+    header[0] = 0xff;
+    header[1] = 0xfe;
+    for (i = 0; i < 4; ++i)
+    {
+      header[2 + i] = (uint8_t)((uint64_t)aad_len >> (24 - 8 * i));
+    }
+    header_len = 6;
+  }
+  else
+  {
+    header[0] = 0xff;
+    header[1] = 0xff;
+    for (i = 0; i < 8; ++i)
+    {
+      header[2 + i] = (uint8_t)((uint64_t)aad_len >> (56 - 8 * i));
+    }
+    header_len = 10;
+  }
+
+  /* CBC-MAC over header | aad, zero padded to a block boundary */
+  pos = 0;
+  for (i = 0; i < header_len + aad_len; ++i)
+  {
+    mac[pos++] ^= (i < header_len) ? header[i] : aad[i - header_len];
+    if (pos == AES_BLOCKLEN)
+    {
+      Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+      pos = 0;
+    }
+  }
+  if (pos != 0)
+  {
+    Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+  }
+  return 0;
+}
+
+/* Fused CTR + CBC-MAC pass: each iteration generates one keystream block and absorbs
+   one plaintext block into the MAC, so the data is only touched once */
+static void CcmCrypt(const struct AES_ctx* ctx, uint8_t* buf, size_t length, uint8_t* mac,
+                     uint8_t* counter, size_t L, int decrypt)
+{
+  uint8_t keystream[AES_BLOCKLEN];
+  size_t i, n;
+
+  while (length > 0)
+  {
+    n = (length < AES_BLOCKLEN) ? length : AES_BLOCKLEN;
+
+    /* A_i with the counter in the last L bytes */
+    for (i = AES_BLOCKLEN - 1; i >= AES_BLOCKLEN - L; --i)
+    {
+      if (++counter[i] != 0)
       {
-	/* inc will overflow */
-        if (ctx->Iv[bi] == 255)
-	{
-          ctx->Iv[bi] = 0;
-          continue;
-        }
-        ctx->Iv[bi] += 1;
         break;
       }
-      bi = 0;
     }
+    memcpy(keystream, counter, AES_BLOCKLEN);
+    Cipher((state_t*)keystream, ctx->RoundKey, BS_KEY(ctx, RoundKey));
 
-    buf[i] = (buf[i] ^ buffer[bi]);
+    for (i = 0; i < n; ++i)
+    {
+      if (decrypt)
+      {
+        buf[i] ^= keystream[i];
+        mac[i] ^= buf[i];
+      }
+      else
+      {
+        mac[i] ^= buf[i];
+        buf[i] ^= keystream[i];
+      }
+    }
+    Cipher((state_t*)mac, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+
+    buf += n;
+    length -= n;
   }
 }
 
-#endif // #if defined(CTR) && (CTR == 1)
+/* T = MAC ^ E_K(A0) */
+static void CcmFinish(const struct AES_ctx* ctx, uint8_t* mac, uint8_t* counter, size_t L)
+{
+  size_t i;
+  for (i = AES_BLOCKLEN - L; i < AES_BLOCKLEN; ++i)
+  {
+    counter[i] = 0;
+  }
+  Cipher((state_t*)counter, ctx->RoundKey, BS_KEY(ctx, RoundKey));
+  for (i = 0; i < AES_BLOCKLEN; ++i)
+  {
+    mac[i] ^= counter[i];
+  }
+}
+
+int AES_CCM_encrypt(const struct AES_ctx* ctx, const uint8_t* nonce, size_t nonce_len,
+                    const uint8_t* aad, size_t aad_len, uint8_t* buf, size_t length,
+                    uint8_t* tag, size_t tag_len)
+{
+  uint8_t mac[AES_BLOCKLEN];
+  uint8_t counter[AES_BLOCKLEN];
+
+  if (CcmStart(ctx, nonce, nonce_len, aad, aad_len, length, tag_len, mac, counter) != 0)
+  {
+    return -1;
+  }
+  CcmCrypt(ctx, buf, length, mac, counter, 15 - nonce_len, 0);
+  CcmFinish(ctx, mac, counter, 15 - nonce_len);
+  memcpy(tag, mac, tag_len);
+  return 0;
+}
+
+int AES_CCM_decrypt(const struct AES_ctx* ctx, const uint8_t* nonce, size_t nonce_len,
+                    const uint8_t* aad, size_t aad_len, uint8_t* buf, size_t length,
+                    const uint8_t* tag, size_t tag_len)
+{
+  uint8_t mac[AES_BLOCKLEN];
+  uint8_t counter[AES_BLOCKLEN];
+  uint8_t diff = 0;
+  size_t i;
+
+  if (CcmStart(ctx, nonce, nonce_len, aad, aad_len, length, tag_len, mac, counter) != 0)
+  {
+    return -1;
+  }
+  CcmCrypt(ctx, buf, length, mac, counter, 15 - nonce_len, 1);
+  CcmFinish(ctx, mac, counter, 15 - nonce_len);
+
+  /* constant-time tag comparison, no plaintext is released on mismatch */
+  for (i = 0; i < tag_len; ++i)
+  {
+    diff |= (uint8_t)(mac[i] ^ tag[i]);
+  }
+  if (diff != 0)
+  {
+    memset(buf, 0, length);
+    return -1;
+  }
+  return 0;
+}
+
+#endif // #if defined(CCM) && (CCM == 1)
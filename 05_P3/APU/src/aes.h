@@ -23,10 +23,62 @@
   #define CTR 1
 #endif
 
+// XTS enables the IEEE 1619 XTS mode for sector-oriented storage encryption.
+#ifndef XTS
+  #define XTS 1
+#endif
+
+// CMAC enables the AES-CMAC message authentication code (NIST SP 800-38B).
+// CCM enables authenticated encryption in CCM mode (NIST SP 800-38C).
+// Both only need the encryption core and a few blocks of stack, no tables.
+#ifndef CMAC
+  #define CMAC 1
+#endif
+
+#ifndef CCM
+  #define CCM 1
+#endif
+
+// BITSLICE takes the S-box tables out of every path that sees key or data: CTR
+// encryption and CBC decryption run through the constant-time bitsliced kernel in
+// aes_bitslice.c, 8 blocks per call with a shorter tail padded to a full call, and
+// the key schedule uses its S-box. The single-block uses (ECB, CBC encryption, XTS,
+// CMAC, CCM) take a padded kernel call per block unless the NEON permute path is
+// active, about 5x slower than the table core on an x86 host.
+// Set it to 0 for the table-based core below.
+#ifndef BITSLICE
+  #define BITSLICE 1
+#endif
+
+// UNROLLED selects the fully unrolled single-block table core: every round of the
+// configured key size written out, the state held in four 32-bit column words. Set it
+// to 0 for the readable round loop with one function per step, e.g. to verify the
+// unrolled one.
+// It only takes effect with BITSLICE 0, otherwise the bitsliced kernel gets every block.
+#ifndef UNROLLED
+  #define UNROLLED 1
+#endif
 
+// NEON_PERMUTE lets the single-block core, CBC, CTR and the key schedule switch at
+// run time to the constant-time NEON table-permute code in aes_neon.c, on AArch64 parts
+// that have Advanced SIMD but not the AES instructions. Whole buffers go in one call,
+// so the S-box is loaded into registers once per buffer, not once per block.
+#ifndef NEON_PERMUTE
+  #if defined(__aarch64__)
+    #define NEON_PERMUTE 1
+  #else
+    #define NEON_PERMUTE 0
+  #endif
+#endif
+
+
+// The key size may also be chosen at compile time (-DAES128=1), check/aes_kat.c is
+// built for AES-128 and AES-256.
+#if !defined(AES128) && !defined(AES192) && !defined(AES256)
 //#define AES128 1
 //#define AES192 1
 #define AES256 1
+#endif
 
 #define AES_BLOCKLEN 16 // Block length in bytes - AES is 128b block only
 
@@ -43,6 +95,9 @@
 
 struct AES_ctx
 {
+#if defined(BITSLICE) && (BITSLICE == 1)
+  uint64_t BsRoundKey[AES_keyExpSize / 8]; // compressed bitsliced round keys
+#endif
   uint8_t RoundKey[AES_keyExpSize];
 #if (defined(CBC) && (CBC == 1)) || (defined(CTR) && (CTR == 1))
   uint8_t Iv[AES_BLOCKLEN];
@@ -73,6 +128,16 @@ void AES_ECB_decrypt(const struct AES_ctx* ctx, uint8_t* buf);
 void AES_CBC_encrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length);
 void AES_CBC_decrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length);
 
+// Encrypts n independent messages, bufs[i] of lens[i] bytes (multiple of AES_BLOCKLEN)
+// with ctxs[i], as n calls of AES_CBC_encrypt_buffer() would. Keys may differ, the
+// contexts must not. Blocks of several messages are encrypted in lockstep, which
+// recovers the parallelism serial CBC encryption lacks: with BITSLICE the 8 lanes of
+// the bitsliced kernel (64 x 256 byte messages about 7x faster than the padded serial
+// loop on an x86 host), otherwise with UNROLLED four lanes of an interleaved T-table
+// core (about 1.9x), which leaves the serial loop in place where the NEON permute path
+// is active.
+void AES_CBC_encrypt_multi(struct AES_ctx* ctxs[], uint8_t* bufs[], const size_t lens[], size_t n);
+
 #endif // #if defined(CBC) && (CBC == 1)
 
 
@@ -88,4 +153,56 @@ void AES_CTR_xcrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, size_t length);
 #endif // #if defined(CTR) && (CTR == 1)
 
 
+#if defined(XTS) && (XTS == 1)
+
+// Two-key context: RoundKey (key1) encrypts the data, TweakKey (key2) the sector number.
+// The context is only read after AES_XTS_init_ctx(), so any number of sectors may be
+// processed concurrently with the same context, e.g. one range of sectors per core.
+struct AES_xts_ctx
+{
+#if defined(BITSLICE) && (BITSLICE == 1)
+  uint64_t BsRoundKey[AES_keyExpSize / 8]; // compressed bitsliced round keys
+  uint64_t BsTweakKey[AES_keyExpSize / 8];
+#endif
+  uint8_t RoundKey[AES_keyExpSize];
+  uint8_t TweakKey[AES_keyExpSize];
+};
+
+void AES_XTS_init_ctx(struct AES_xts_ctx* ctx, const uint8_t* key1, const uint8_t* key2);
+
+// Each call processes one data unit (sector) in place, the tweak is derived from the
+// sector number as a 128-bit little-endian value.
+// length must be at least AES_BLOCKLEN, other lengths are handled with ciphertext
+// stealing so that the output has the same size as the input.
+// Return 0 on success, -1 if length is below AES_BLOCKLEN; buf is left unchanged then.
+int AES_XTS_encrypt_sector(const struct AES_xts_ctx* ctx, uint64_t sector, uint8_t* buf, size_t length);
+int AES_XTS_decrypt_sector(const struct AES_xts_ctx* ctx, uint64_t sector, uint8_t* buf, size_t length);
+
+#endif // #if defined(XTS) && (XTS == 1)
+
+
+#if defined(CMAC) && (CMAC == 1)
+
+// mac receives AES_BLOCKLEN bytes; only the RoundKey of ctx is used
+void AES_CMAC(const struct AES_ctx* ctx, const uint8_t* msg, size_t length, uint8_t* mac);
+
+#endif // #if defined(CMAC) && (CMAC == 1)
+
+
+#if defined(CCM) && (CCM == 1)
+
+// In-place CCM on buf, only the RoundKey of ctx is used.
+// nonce_len 7..13 bytes, tag_len 4, 6, .., 16 bytes, aad may be NULL if aad_len is 0.
+// Return 0 on success, -1 on invalid parameters; decrypt also returns -1 if the tag
+// does not match, in which case buf is cleared.
+int AES_CCM_encrypt(const struct AES_ctx* ctx, const uint8_t* nonce, size_t nonce_len,
+                    const uint8_t* aad, size_t aad_len, uint8_t* buf, size_t length,
+                    uint8_t* tag, size_t tag_len);
+int AES_CCM_decrypt(const struct AES_ctx* ctx, const uint8_t* nonce, size_t nonce_len,
+                    const uint8_t* aad, size_t aad_len, uint8_t* buf, size_t length,
+                    const uint8_t* tag, size_t tag_len);
+
+#endif // #if defined(CCM) && (CCM == 1)
+
+
 #endif // _AES_H_
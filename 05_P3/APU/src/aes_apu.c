@@ -2,7 +2,12 @@
  * @file
  * @brief APU-based AES encryption
  *
- * @note 
+ * @note The software core (aes.c) keeps no state outside the context, so the wrapper
+ * is reentrant as long as each thread works on its own aes_apu_ctx_t. The legacy
+ * functions without a context argument operate on one process-wide default context,
+ * so a key set up in one thread can be used from another, but concurrent callers
+ * must serialise. With AES_APU_THREAD_DEFAULT the default context is thread-local
+ * instead and needs no mutex, every thread then initialises its own.
  *
  * --------------------------------------------------------------------------------------
  * @author  Flavio Felder, felf@zhaw.ch
@@ -14,25 +19,80 @@
  ***************************************************************************************/
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "aes_apu.h"
 #include "aes.h"
 
 /****************************************************************************************
  * Variables
  ***************************************************************************************/
-static struct AES_ctx ctx;
+#if AES_APU_THREAD_DEFAULT
+static __thread aes_apu_ctx_t default_ctx;
+#else
+static aes_apu_ctx_t default_ctx;
+#endif
 
 /****************************************************************************************
  * Global Functions
  ***************************************************************************************/
 
+/****************************************************************************************
+ * @brief Initialize a context with key and initialization vector
+ * @param ctx[out]	Context
+ * @param key[in]	Key
+ * @param iv[in]	Initialization vector
+ ***************************************************************************************/
+void AES_APU_ctx_init(aes_apu_ctx_t* ctx, const uint8_t* key, const uint8_t* iv) {
+	AES_init_ctx_iv(&ctx->aes, key, iv);
+}
+
+/****************************************************************************************
+ * @brief Set a new initialization vector, the key is kept
+ * @param ctx[in,out]	Context
+ * @param iv[in]		Initialization vector
+ ***************************************************************************************/
+void AES_APU_ctx_set_iv(aes_apu_ctx_t* ctx, const uint8_t* iv) {
+	AES_ctx_set_iv(&ctx->aes, iv);
+}
+
+/****************************************************************************************
+ * @brief CBC encryption, the IV in the context is chained for the next call
+ * @param ctx[in,out]	Context
+ * @param buf[in]		Plain text
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ ***************************************************************************************/
+void AES_APU_ctx_encrypt_buffer(aes_apu_ctx_t* ctx, uint8_t* buf, size_t length) {
+	AES_CBC_encrypt_buffer(&ctx->aes, buf, length);
+}
+
+/****************************************************************************************
+ * @brief CBC decryption, the IV in the context is chained for the next call
+ * @param ctx[in,out]	Context
+ * @param buf[in]		Cipher text
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ ***************************************************************************************/
+void AES_APU_ctx_decrypt_buffer(aes_apu_ctx_t* ctx, uint8_t* buf, size_t length) {
+	AES_CBC_decrypt_buffer(&ctx->aes, buf, length);
+}
+
+/****************************************************************************************
+ * @brief Wipe the key material of a context
+ * @param ctx[out]	Context
+ ***************************************************************************************/
+void AES_APU_ctx_clear(aes_apu_ctx_t* ctx) {
+	volatile uint8_t *p = (volatile uint8_t *)ctx;
+	for (size_t i = 0; i < sizeof(*ctx); i++) {
+		p[i] = 0;
+	}
+}
+
 /****************************************************************************************
  * @brief APU-based AES encryption initialization
  * @param key[in]	Key
  * @param iv[in]	Initialization vector
  ***************************************************************************************/
 void AES_APU_init_ctx_iv(const uint8_t* key, const uint8_t* iv) {
-	AES_init_ctx_iv(&ctx, key, iv);
+	AES_APU_ctx_init(&default_ctx, key, iv);
 }
 
 /****************************************************************************************
@@ -41,7 +101,7 @@ void AES_APU_init_ctx_iv(const uint8_t* key, const uint8_t* iv) {
  * @param length[in]	Length of text (must be divisible by 16byte)
  ***************************************************************************************/
 void AES_APU_encrypt_buffer(uint8_t* buf, size_t length) {
-	AES_CBC_encrypt_buffer(&ctx, buf, length);
+	AES_APU_ctx_encrypt_buffer(&default_ctx, buf, length);
 }
 
 /****************************************************************************************
@@ -50,5 +110,5 @@ void AES_APU_encrypt_buffer(uint8_t* buf, size_t length) {
  * @param length[in]	Length of text (must be divisible by 16byte)
  ***************************************************************************************/
 void AES_APU_decrypt_buffer(uint8_t* buf, size_t length) {
-	AES_CBC_decrypt_buffer(&ctx, buf, length);
+	AES_APU_ctx_decrypt_buffer(&default_ctx, buf, length);
 }
@@ -10,14 +10,45 @@
  * Includes
  ***************************************************************************************/
 #include <stdint.h>
+#include <stddef.h>
+#include "aes.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+
+/* 0: one process-wide default context for the legacy API as before, callers must
+ *    serialise
+ * 1: every thread gets its own default context (thread-local). A thread then has to
+ *    call AES_APU_init_ctx_iv() itself, a key set up in another thread is not seen */
+#ifndef AES_APU_THREAD_DEFAULT
+#define AES_APU_THREAD_DEFAULT	0
+#endif
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+
+/* Context handle, owned by the caller. Calls with different contexts may run
+ * concurrently, a single context must not be used by two threads at once. */
+typedef struct {
+	struct AES_ctx aes;
+} aes_apu_ctx_t;
 
 /****************************************************************************************
  * Functions
  ***************************************************************************************/
 
-// TODO add comments
+// Context API, reentrant
+void AES_APU_ctx_init(aes_apu_ctx_t* ctx, const uint8_t* key, const uint8_t* iv);
+void AES_APU_ctx_set_iv(aes_apu_ctx_t* ctx, const uint8_t* iv);
+void AES_APU_ctx_encrypt_buffer(aes_apu_ctx_t* ctx, uint8_t* buf, size_t length);
+void AES_APU_ctx_decrypt_buffer(aes_apu_ctx_t* ctx, uint8_t* buf, size_t length);
+void AES_APU_ctx_clear(aes_apu_ctx_t* ctx);
+
+// Legacy API on the default context of the calling thread
 void AES_APU_init_ctx_iv(const uint8_t* key, const uint8_t* iv);
 void AES_APU_encrypt_buffer(uint8_t* buf, size_t length);
 void AES_APU_decrypt_buffer(uint8_t* buf, size_t length);
 
-#endif  /* AES_APU_H */
\ No newline at end of file
+#endif  /* AES_APU_H */
@@ -0,0 +1,373 @@
+/****************************************************************************************
+ * @file
+ * @brief Vector-permute AES for A53 parts without the crypto extension
+ *
+ * @note All S-box evaluations are NEON table lookups (tbl/tbx) on tables held in
+ * vector registers, so no memory access depends on key or data. ShiftRows and the
+ * byte rotations of MixColumns are fixed permutations, the GF(2^8) doubling is a
+ * shift and a masked XOR. The tables take 16 vector registers and are loaded once
+ * per call, so the entries take whole buffers: n blocks in ECB or CBC order, or the
+ * complete key schedule. That makes the path a drop-in for the serial modes and for
+ * the key schedule, where the bitsliced kernel (aes_bitslice.c) does not apply.
+ *
+ * The path is used when the kernel reports Advanced SIMD (HWCAP_ASIMD) but not the
+ * AES instructions (HWCAP_AES), see AES_NEON_available(). The A53 of the board has
+ * them, there the path only runs when forced: AES_FORCE_NEON=1 in the environment, or
+ * AES_NEON_force() as in check/aes_check.c.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include "aes_neon.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <stdlib.h>
+#include <string.h>
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+static const uint8_t neon_sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static const uint8_t neon_rsbox[256] = {
+	0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+	0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+	0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+	0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+	0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+	0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+	0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+	0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+	0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+	0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+	0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+	0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+	0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+	0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+	0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+	0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+};
+
+/* byte permutations within the 16-byte state, column-major as in aes.c */
+static const uint8_t neon_shift_rows[16]		= { 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 };
+static const uint8_t neon_inv_shift_rows[16]	= { 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 };
+static const uint8_t neon_rot1[16]				= { 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 };
+static const uint8_t neon_rot2[16]				= { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 };
+static const uint8_t neon_rot3[16]				= { 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14 };
+
+static int neon_state = -1;		// -1 not probed yet, 0 not usable, 1 usable, atomic access
+
+/****************************************************************************************
+ * Local Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Load a 256-byte table into 16 vector registers
+ ***************************************************************************************/
+static inline void neon_load_table(uint8x16x4_t* t, const uint8_t* table) {
+	t[0] = vld1q_u8_x4(table);
+	t[1] = vld1q_u8_x4(table + 64);
+	t[2] = vld1q_u8_x4(table + 128);
+	t[3] = vld1q_u8_x4(table + 192);
+}
+
+/****************************************************************************************
+ * @brief Substitute all 16 bytes, indices outside a 64-byte quarter keep the result
+ ***************************************************************************************/
+static inline uint8x16_t neon_lookup(const uint8x16x4_t* t, uint8x16_t x) {
+	const uint8x16_t quarter = vdupq_n_u8(0x40);
+	uint8x16_t r;
+
+	r = vqtbl4q_u8(t[0], x);
+	x = vsubq_u8(x, quarter);
+	r = vqtbx4q_u8(r, t[1], x);
+	x = vsubq_u8(x, quarter);
+	r = vqtbx4q_u8(r, t[2], x);
+	x = vsubq_u8(x, quarter);
+	r = vqtbx4q_u8(r, t[3], x);
+	return r;
+}
+
+/****************************************************************************************
+ * @brief Multiplication by {02} in GF(2^8), constant time
+ ***************************************************************************************/
+static inline uint8x16_t neon_xtime(uint8x16_t x) {
+	uint8x16_t carry = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(x), 7));
+	return veorq_u8(vshlq_n_u8(x, 1), vandq_u8(carry, vdupq_n_u8(0x1b)));
+}
+
+/****************************************************************************************
+ * @brief MixColumns: b[r] = 2*(a[r]^a[r+1]) ^ a[r+1] ^ a[r+2] ^ a[r+3]
+ ***************************************************************************************/
+static inline uint8x16_t neon_mix_columns(uint8x16_t a) {
+	uint8x16_t a1 = vqtbl1q_u8(a, vld1q_u8(neon_rot1));
+	uint8x16_t a2 = vqtbl1q_u8(a, vld1q_u8(neon_rot2));
+	uint8x16_t a3 = vqtbl1q_u8(a, vld1q_u8(neon_rot3));
+
+	return veorq_u8(veorq_u8(neon_xtime(veorq_u8(a, a1)), a1), veorq_u8(a2, a3));
+}
+
+/****************************************************************************************
+ * @brief InvMixColumns as {05,00,04,00} followed by MixColumns
+ ***************************************************************************************/
+static inline uint8x16_t neon_inv_mix_columns(uint8x16_t a) {
+	uint8x16_t a2 = vqtbl1q_u8(a, vld1q_u8(neon_rot2));
+	uint8x16_t u = neon_xtime(neon_xtime(veorq_u8(a, a2)));
+
+	return neon_mix_columns(veorq_u8(a, u));
+}
+
+/****************************************************************************************
+ * @brief Encrypt one block with the S-box already in t
+ ***************************************************************************************/
+static inline uint8x16_t neon_encrypt_block(const uint8x16x4_t* t, const uint8_t* RoundKey,
+		unsigned Nr, uint8x16_t s) {
+	const uint8x16_t shift_rows = vld1q_u8(neon_shift_rows);
+
+	s = veorq_u8(s, vld1q_u8(RoundKey));
+	for (unsigned round = 1; round < Nr; round++) {
+		s = neon_lookup(t, vqtbl1q_u8(s, shift_rows));
+		s = neon_mix_columns(s);
+		s = veorq_u8(s, vld1q_u8(RoundKey + 16*round));
+	}
+	s = neon_lookup(t, vqtbl1q_u8(s, shift_rows));
+	return veorq_u8(s, vld1q_u8(RoundKey + 16*Nr));
+}
+
+/****************************************************************************************
+ * @brief Decrypt one block with the inverse S-box already in t
+ ***************************************************************************************/
+static inline uint8x16_t neon_decrypt_block(const uint8x16x4_t* t, const uint8_t* RoundKey,
+		unsigned Nr, uint8x16_t s) {
+	const uint8x16_t inv_shift_rows = vld1q_u8(neon_inv_shift_rows);
+
+	s = veorq_u8(s, vld1q_u8(RoundKey + 16*Nr));
+	for (unsigned round = Nr - 1; round > 0; round--) {
+		s = neon_lookup(t, vqtbl1q_u8(s, inv_shift_rows));
+		s = veorq_u8(s, vld1q_u8(RoundKey + 16*round));
+		s = neon_inv_mix_columns(s);
+	}
+	s = neon_lookup(t, vqtbl1q_u8(s, inv_shift_rows));
+	return veorq_u8(s, vld1q_u8(RoundKey));
+}
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Check once whether the vector-permute path should be used
+ * @return 1 with Advanced SIMD and without the AES instructions, or with Advanced SIMD
+ * and AES_FORCE_NEON set to anything but "0" in the environment; 0 otherwise
+ ***************************************************************************************/
+int AES_NEON_available(void) {
+	int state = __atomic_load_n(&neon_state, __ATOMIC_RELAXED);
+
+	/* threads racing here all store the same value */
+	if (state < 0) {
+		unsigned long hwcap = getauxval(AT_HWCAP);
+		const char *force = getenv("AES_FORCE_NEON");
+		int forced = (force != NULL) && (force[0] != '\0') && (strcmp(force, "0") != 0);
+
+		state = ((hwcap & HWCAP_ASIMD) != 0) && (forced || ((hwcap & HWCAP_AES) == 0));
+		__atomic_store_n(&neon_state, state, __ATOMIC_RELAXED);
+	}
+	return state;
+}
+
+/****************************************************************************************
+ * @brief Switch the path on regardless of the AES instructions, or back to detection
+ * @note Not thread-safe against running ciphers, meant for tests
+ * @param on[in]		1 force on, 0 detect again on the next call
+ * @return 0 if done, -1 without Advanced SIMD
+ ***************************************************************************************/
+int AES_NEON_force(int on) {
+	if (!on) {
+		__atomic_store_n(&neon_state, -1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	if ((getauxval(AT_HWCAP) & HWCAP_ASIMD) == 0) {
+		return -1;
+	}
+	__atomic_store_n(&neon_state, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Expand a key as KeyExpansion() in aes.c, the S-box loaded once for all words
+ * @param RoundKey[out]	16 * (Nr + 1) bytes
+ * @param Key[in]		4 * Nk bytes
+ * @param Nk[in]		Number of 32-bit words in the key (4, 6 or 8)
+ * @param Nr[in]		Number of rounds
+ ***************************************************************************************/
+void AES_NEON_key_expansion(uint8_t* RoundKey, const uint8_t* Key, unsigned Nk, unsigned Nr) {
+	uint8x16x4_t t[4];
+	uint8_t tmp[16] = { 0 };
+	uint8_t rcon = 0x01;
+
+	neon_load_table(t, neon_sbox);
+	memcpy(RoundKey, Key, 4 * Nk);
+	for (unsigned i = Nk; i < 4 * (Nr + 1); i++) {
+		memcpy(tmp, RoundKey + 4 * (i - 1), 4);
+		if (i % Nk == 0) {
+			/* RotWord, SubWord and Rcon */
+			const uint8_t b0 = tmp[0];
+			tmp[0] = tmp[1];
+			tmp[1] = tmp[2];
+			tmp[2] = tmp[3];
+			tmp[3] = b0;
+			vst1q_u8(tmp, neon_lookup(t, vld1q_u8(tmp)));
+			tmp[0] ^= rcon;
+			rcon = (uint8_t)((rcon << 1) ^ (0x1b & -(rcon >> 7)));
+		} else if (Nk > 6 && i % Nk == 4) {
+			vst1q_u8(tmp, neon_lookup(t, vld1q_u8(tmp)));
+		}
+		for (unsigned j = 0; j < 4; j++) {
+			RoundKey[4 * i + j] = RoundKey[4 * (i - Nk) + j] ^ tmp[j];
+		}
+	}
+}
+
+/****************************************************************************************
+ * @brief Encrypt n consecutive blocks in place (ECB), the S-box loaded once per call
+ * @param RoundKey[in]		Expanded key from aes.c
+ * @param Nr[in]			Number of rounds
+ * @param blocks[in,out]	16 * n bytes
+ * @param n[in]				Number of blocks
+ ***************************************************************************************/
+void AES_NEON_encrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n) {
+	uint8x16x4_t t[4];
+
+	neon_load_table(t, neon_sbox);
+	for (size_t i = 0; i < n; i++) {
+		vst1q_u8(blocks + 16*i, neon_encrypt_block(t, RoundKey, Nr, vld1q_u8(blocks + 16*i)));
+	}
+}
+
+/****************************************************************************************
+ * @brief Decrypt n consecutive blocks in place (ECB), the S-box loaded once per call
+ * @param RoundKey[in]		Expanded key from aes.c
+ * @param Nr[in]			Number of rounds
+ * @param blocks[in,out]	16 * n bytes
+ * @param n[in]				Number of blocks
+ ***************************************************************************************/
+void AES_NEON_decrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n) {
+	uint8x16x4_t t[4];
+
+	neon_load_table(t, neon_rsbox);
+	for (size_t i = 0; i < n; i++) {
+		vst1q_u8(blocks + 16*i, neon_decrypt_block(t, RoundKey, Nr, vld1q_u8(blocks + 16*i)));
+	}
+}
+
+/****************************************************************************************
+ * @brief CBC encryption of n blocks in place, the chain stays in a register
+ * @param RoundKey[in]		Expanded key from aes.c
+ * @param Nr[in]			Number of rounds
+ * @param iv[in,out]		16 bytes, the last cipher block on return
+ * @param buf[in,out]		16 * n bytes
+ * @param n[in]				Number of blocks
+ ***************************************************************************************/
+void AES_NEON_cbc_encrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n) {
+	uint8x16x4_t t[4];
+	uint8x16_t chain = vld1q_u8(iv);
+
+	neon_load_table(t, neon_sbox);
+	for (size_t i = 0; i < n; i++) {
+		chain = neon_encrypt_block(t, RoundKey, Nr, veorq_u8(vld1q_u8(buf + 16*i), chain));
+		vst1q_u8(buf + 16*i, chain);
+	}
+	vst1q_u8(iv, chain);
+}
+
+/****************************************************************************************
+ * @brief CBC decryption of n blocks in place
+ * @param RoundKey[in]		Expanded key from aes.c
+ * @param Nr[in]			Number of rounds
+ * @param iv[in,out]		16 bytes, the last cipher block on return
+ * @param buf[in,out]		16 * n bytes
+ * @param n[in]				Number of blocks
+ ***************************************************************************************/
+void AES_NEON_cbc_decrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n) {
+	uint8x16x4_t t[4];
+	uint8x16_t chain = vld1q_u8(iv);
+
+	neon_load_table(t, neon_rsbox);
+	for (size_t i = 0; i < n; i++) {
+		uint8x16_t c = vld1q_u8(buf + 16*i);
+		vst1q_u8(buf + 16*i, veorq_u8(neon_decrypt_block(t, RoundKey, Nr, c), chain));
+		chain = c;
+	}
+	vst1q_u8(iv, chain);
+}
+
+#else
+
+/* Not an AArch64 build: the path is never selected */
+int AES_NEON_available(void) {
+	return 0;
+}
+
+int AES_NEON_force(int on) {
+	return on ? -1 : 0;
+}
+
+void AES_NEON_key_expansion(uint8_t* RoundKey, const uint8_t* Key, unsigned Nk, unsigned Nr) {
+	(void)RoundKey;
+	(void)Key;
+	(void)Nk;
+	(void)Nr;
+}
+
+void AES_NEON_encrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n) {
+	(void)RoundKey;
+	(void)Nr;
+	(void)blocks;
+	(void)n;
+}
+
+void AES_NEON_decrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n) {
+	(void)RoundKey;
+	(void)Nr;
+	(void)blocks;
+	(void)n;
+}
+
+void AES_NEON_cbc_encrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n) {
+	(void)RoundKey;
+	(void)Nr;
+	(void)iv;
+	(void)buf;
+	(void)n;
+}
+
+void AES_NEON_cbc_decrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n) {
+	(void)RoundKey;
+	(void)Nr;
+	(void)iv;
+	(void)buf;
+	(void)n;
+}
+
+#endif
@@ -0,0 +1,26 @@
+/****************************************************************************************
+ * @file
+ * @brief See aes_neon.c
+ ***************************************************************************************/
+
+#ifndef AES_NEON_H
+#define AES_NEON_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+int AES_NEON_available(void);
+int AES_NEON_force(int on);
+void AES_NEON_key_expansion(uint8_t* RoundKey, const uint8_t* Key, unsigned Nk, unsigned Nr);
+void AES_NEON_encrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n);
+void AES_NEON_decrypt_blocks(const uint8_t* RoundKey, unsigned Nr, uint8_t* blocks, size_t n);
+void AES_NEON_cbc_encrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n);
+void AES_NEON_cbc_decrypt(const uint8_t* RoundKey, unsigned Nr, uint8_t* iv, uint8_t* buf, size_t n);
+
+#endif  /* AES_NEON_H */
@@ -19,7 +19,7 @@
 #include <string.h>
 #include <time.h>
 #include "aes_apu.h"
-
+#include "timing.h"
 
 /****************************************************************************************
  * Functions
@@ -92,21 +92,30 @@ int main(void) {
         return 1;
     }
 
-    struct timespec time_start, time_stop;
-    float time;
+    timing_run_t run;
+    aes_apu_ctx_t ctx;
+    int ok;
 
-    printf("\nTesting AES256\n");
+    printf("\nTesting AES256 (build: %s)\n", BUILD_TYPE);
 
-    // TODO geeignete Zeitmessung einbauen
-    clock_gettime(CLOCK_REALTIME, &time_start);
+    TIMING_init(&run);
 
-    AES_APU_init_ctx_iv(key, iv);
-    AES_APU_encrypt_buffer(enc_a, text_length);
+    TIMING_begin(&run, TIMING_KEY_SETUP);
+    AES_APU_ctx_init(&ctx, key, iv);
+    TIMING_end(&run, TIMING_KEY_SETUP);
 
-    clock_gettime(CLOCK_REALTIME, &time_stop);
+    TIMING_begin(&run, TIMING_ENCRYPT);
+    AES_APU_ctx_encrypt_buffer(&ctx, enc_a, text_length);
+    TIMING_end(&run, TIMING_ENCRYPT);
 
-    AES_APU_init_ctx_iv(key, iv);
-    AES_APU_decrypt_buffer(dec_a, text_length);
+    TIMING_begin(&run, TIMING_DECRYPT);
+    AES_APU_ctx_set_iv(&ctx, iv);
+    AES_APU_ctx_decrypt_buffer(&ctx, dec_a, text_length);
+    TIMING_end(&run, TIMING_DECRYPT);
+
+    TIMING_begin(&run, TIMING_TEARDOWN);
+    AES_APU_ctx_clear(&ctx);
+    TIMING_end(&run, TIMING_TEARDOWN);
 
     printf("\n");
     printf("Input:  "); print_hex(dec_t, text_length);
@@ -114,7 +123,8 @@ int main(void) {
     printf("Soll:   "); print_hex(enc_t, text_length);
 
     printf("AES encrypt: ");
-    if (0 == memcmp((char*) enc_t, (char*) enc_a, text_length)) {
+    ok = (0 == memcmp((char*) enc_t, (char*) enc_a, text_length));
+    if (ok) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
@@ -130,6 +140,7 @@ int main(void) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
+        ok = 0;
     }
 
     //Geheime Nachricht
@@ -140,11 +151,9 @@ int main(void) {
     printf("Plaintext:  %s\n", (char *)secret_a);
     
     // Zeitauswertung
-    time = (time_stop.tv_sec + time_stop.tv_nsec*1e-9)
-         - (time_start.tv_sec + time_start.tv_nsec*1e-9);
-
-    printf("\nMeasurement for setup, encryption, setup, decryption; Message size %li Bytes\n",text_length);
-    printf("Time: %.3f ms\n",time*1000);
+    printf("\nMeasurement per phase; Message size %zu Bytes\n", text_length);
+    TIMING_print(&run);
+    TIMING_print_json(&run, "apu", text_length, ok);
 
     return 0;
 }
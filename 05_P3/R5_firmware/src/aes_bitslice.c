@@ -0,0 +1,677 @@
+/****************************************************************************************
+ * @file
+ * @brief Bitsliced constant-time AES kernel, 8 blocks per call
+ *
+ * @note The tiny-AES core (aes.c) indexes sbox/rsbox with secret data, so its timing
+ * depends on the cache state and the key. This kernel computes the cipher with
+ * logic operations only: no table lookup and no branch depends on key or data.
+ *
+ * Representation (BearSSL ct64 style): 4 blocks are transposed into 8 words of 64
+ * bits, word i holds bit i of every byte of the 4 blocks. Two such groups are
+ * processed in parallel, one per 64-bit lane of a 128-bit vector:
+ * - NEON on the A53, one uint64x2_t register per bit plane
+ * - portable 32-bit scalar code on the R5 and M4, where the compiler splits each
+ *   64-bit lane into 32-bit register pairs
+ * The 32-bit pairs hold 2 blocks per 32-bit word, as the ct32 layout would, so the
+ * gate count per block is the same; the layout stays shared with the NEON path and
+ * with the merged lane keys of AES_BS_set_lane_key().
+ *
+ * SubBytes is the Boyar-Peralta circuit (113 XOR/AND/XNOR gates), InvSubBytes wraps
+ * it with the inverse affine transform. The round keys come from the regular key
+ * expansion and are stored in compressed form (AES_BS_KEYWORDS(Nr) words), they
+ * are expanded on the fly per round to keep the stack small on the R5.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include "aes_bitslice.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+typedef uint64x2_t bs_t;
+#define BS_XOR(a, b)		veorq_u64((a), (b))
+#define BS_AND(a, b)		vandq_u64((a), (b))
+#define BS_OR(a, b)			vorrq_u64((a), (b))
+#define BS_NOT(a)			vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(a)))
+#define BS_SHL(a, n)		vshlq_n_u64((a), (n))
+#define BS_SHR(a, n)		vshrq_n_u64((a), (n))
+#define BS_MASK(a, m)		vandq_u64((a), vdupq_n_u64(m))
+#define BS_SET(lo, hi)		vcombine_u64(vcreate_u64(lo), vcreate_u64(hi))
+#define BS_DUP(x)			vdupq_n_u64(x)
+#define BS_LO(a)			vgetq_lane_u64((a), 0)
+#define BS_HI(a)			vgetq_lane_u64((a), 1)
+#else
+typedef struct {
+	uint64_t lo;
+	uint64_t hi;
+} bs_t;
+
+static inline bs_t bs_make(uint64_t lo, uint64_t hi) {
+	bs_t r = { lo, hi };
+	return r;
+}
+
+#define BS_XOR(a, b)		bs_make((a).lo ^ (b).lo, (a).hi ^ (b).hi)
+#define BS_AND(a, b)		bs_make((a).lo & (b).lo, (a).hi & (b).hi)
+#define BS_OR(a, b)			bs_make((a).lo | (b).lo, (a).hi | (b).hi)
+#define BS_NOT(a)			bs_make(~(a).lo, ~(a).hi)
+#define BS_SHL(a, n)		bs_make((a).lo << (n), (a).hi << (n))
+#define BS_SHR(a, n)		bs_make((a).lo >> (n), (a).hi >> (n))
+#define BS_MASK(a, m)		bs_make((a).lo & (uint64_t)(m), (a).hi & (uint64_t)(m))
+#define BS_SET(lo, hi)		bs_make((lo), (hi))
+#define BS_DUP(x)			bs_make((x), (x))
+#define BS_LO(a)			((a).lo)
+#define BS_HI(a)			((a).hi)
+#endif
+
+#define BS_ROTR16(a)		BS_OR(BS_SHR(a, 16), BS_SHL(a, 48))
+#define BS_ROTR32(a)		BS_OR(BS_SHR(a, 32), BS_SHL(a, 32))
+
+/* Exchange the bits selected by cl in y with the bits selected by ch in x */
+#define BS_SWAPN(cl, ch, s, x, y)	do { \
+		bs_t a_ = (x), b_ = (y); \
+		(x) = BS_OR(BS_MASK(a_, cl), BS_SHL(BS_MASK(b_, cl), s)); \
+		(y) = BS_OR(BS_SHR(BS_MASK(a_, ch), s), BS_MASK(b_, ch)); \
+	} while (0)
+
+#define BS_SWAP2(x, y)	BS_SWAPN(0x5555555555555555ull, 0xAAAAAAAAAAAAAAAAull, 1, x, y)
+#define BS_SWAP4(x, y)	BS_SWAPN(0x3333333333333333ull, 0xCCCCCCCCCCCCCCCCull, 2, x, y)
+#define BS_SWAP8(x, y)	BS_SWAPN(0x0F0F0F0F0F0F0F0Full, 0xF0F0F0F0F0F0F0F0ull, 4, x, y)
+
+/****************************************************************************************
+ * Local Functions
+ ***************************************************************************************/
+
+static inline uint32_t bs_dec32le(const uint8_t *src) {
+	return (uint32_t)src[0]
+	     | (uint32_t)src[1] << 8
+	     | (uint32_t)src[2] << 16
+	     | (uint32_t)src[3] << 24;
+}
+
+static inline void bs_enc32le(uint8_t *dst, uint32_t x) {
+	dst[0] = (uint8_t)(x);
+	dst[1] = (uint8_t)(x >> 8);
+	dst[2] = (uint8_t)(x >> 16);
+	dst[3] = (uint8_t)(x >> 24);
+}
+
+/****************************************************************************************
+ * @brief Transpose between byte order and bit planes (self-inverse)
+ ***************************************************************************************/
+static void bs_ortho(bs_t *q) {
+	BS_SWAP2(q[0], q[1]);
+	BS_SWAP2(q[2], q[3]);
+	BS_SWAP2(q[4], q[5]);
+	BS_SWAP2(q[6], q[7]);
+
+	BS_SWAP4(q[0], q[2]);
+	BS_SWAP4(q[1], q[3]);
+	BS_SWAP4(q[4], q[6]);
+	BS_SWAP4(q[5], q[7]);
+
+	BS_SWAP8(q[0], q[4]);
+	BS_SWAP8(q[1], q[5]);
+	BS_SWAP8(q[2], q[6]);
+	BS_SWAP8(q[3], q[7]);
+}
+
+/****************************************************************************************
+ * @brief Spread one block (4 words) over two 64-bit words, 16 bits per column
+ ***************************************************************************************/
+static void bs_interleave_in(uint64_t *q0, uint64_t *q1, const uint32_t *w) {
+	uint64_t x0 = w[0], x1 = w[1], x2 = w[2], x3 = w[3];
+
+	x0 |= (x0 << 16);
+	x1 |= (x1 << 16);
+	x2 |= (x2 << 16);
+	x3 |= (x3 << 16);
+	x0 &= 0x0000FFFF0000FFFFull;
+	x1 &= 0x0000FFFF0000FFFFull;
+	x2 &= 0x0000FFFF0000FFFFull;
+	x3 &= 0x0000FFFF0000FFFFull;
+	x0 |= (x0 << 8);
+	x1 |= (x1 << 8);
+	x2 |= (x2 << 8);
+	x3 |= (x3 << 8);
+	x0 &= 0x00FF00FF00FF00FFull;
+	x1 &= 0x00FF00FF00FF00FFull;
+	x2 &= 0x00FF00FF00FF00FFull;
+	x3 &= 0x00FF00FF00FF00FFull;
+	*q0 = x0 | (x2 << 8);
+	*q1 = x1 | (x3 << 8);
+}
+
+static void bs_interleave_out(uint32_t *w, uint64_t q0, uint64_t q1) {
+	uint64_t x0, x1, x2, x3;
+
+	x0 = q0 & 0x00FF00FF00FF00FFull;
+	x1 = q1 & 0x00FF00FF00FF00FFull;
+	x2 = (q0 >> 8) & 0x00FF00FF00FF00FFull;
+	x3 = (q1 >> 8) & 0x00FF00FF00FF00FFull;
+	x0 |= (x0 >> 8);
+	x1 |= (x1 >> 8);
+	x2 |= (x2 >> 8);
+	x3 |= (x3 >> 8);
+	x0 &= 0x0000FFFF0000FFFFull;
+	x1 &= 0x0000FFFF0000FFFFull;
+	x2 &= 0x0000FFFF0000FFFFull;
+	x3 &= 0x0000FFFF0000FFFFull;
+	w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+	w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+	w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+	w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+/****************************************************************************************
+ * @brief Load 8 blocks into bit planes, blocks 0..3 in the low lane, 4..7 in the high
+ ***************************************************************************************/
+static void bs_load(bs_t *q, const uint8_t *blocks) {
+	uint64_t lane[2][8];
+	uint32_t w[4];
+
+	for (int l = 0; l < 2; l++) {
+		for (int i = 0; i < 4; i++) {
+			const uint8_t *b = blocks + 64*l + 16*i;
+			w[0] = bs_dec32le(b);
+			w[1] = bs_dec32le(b + 4);
+			w[2] = bs_dec32le(b + 8);
+			w[3] = bs_dec32le(b + 12);
+			bs_interleave_in(&lane[l][i], &lane[l][i + 4], w);
+		}
+	}
+	for (int i = 0; i < 8; i++) {
+		q[i] = BS_SET(lane[0][i], lane[1][i]);
+	}
+	bs_ortho(q);
+}
+
+static void bs_store(uint8_t *blocks, bs_t *q) {
+	uint64_t lane[2][8];
+	uint32_t w[4];
+
+	bs_ortho(q);
+	for (int i = 0; i < 8; i++) {
+		lane[0][i] = BS_LO(q[i]);
+		lane[1][i] = BS_HI(q[i]);
+	}
+	for (int l = 0; l < 2; l++) {
+		for (int i = 0; i < 4; i++) {
+			uint8_t *b = blocks + 64*l + 16*i;
+			bs_interleave_out(w, lane[l][i], lane[l][i + 4]);
+			bs_enc32le(b, w[0]);
+			bs_enc32le(b + 4, w[1]);
+			bs_enc32le(b + 8, w[2]);
+			bs_enc32le(b + 12, w[3]);
+		}
+	}
+}
+
+/****************************************************************************************
+ * @brief SubBytes, Boyar-Peralta circuit on the 8 bit planes
+ ***************************************************************************************/
+static void bs_sbox(bs_t *q) {
+	bs_t x0, x1, x2, x3, x4, x5, x6, x7;
+	bs_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	bs_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	bs_t y20, y21;
+	bs_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	bs_t z10, z11, z12, z13, z14, z15, z16, z17;
+	bs_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	bs_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	bs_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	bs_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	bs_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	bs_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	bs_t t60, t61, t62, t63, t64, t65, t66, t67;
+	bs_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	// top linear transformation
+	y14 = BS_XOR(x3, x5);
+	y13 = BS_XOR(x0, x6);
+	y9 = BS_XOR(x0, x3);
+	y8 = BS_XOR(x0, x5);
+	t0 = BS_XOR(x1, x2);
+	y1 = BS_XOR(t0, x7);
+	y4 = BS_XOR(y1, x3);
+	y12 = BS_XOR(y13, y14);
+	y2 = BS_XOR(y1, x0);
+	y5 = BS_XOR(y1, x6);
+	y3 = BS_XOR(y5, y8);
+	t1 = BS_XOR(x4, y12);
+	y15 = BS_XOR(t1, x5);
+	y20 = BS_XOR(t1, x1);
+	y6 = BS_XOR(y15, x7);
+	y10 = BS_XOR(y15, t0);
+	y11 = BS_XOR(y20, y9);
+	y7 = BS_XOR(x7, y11);
+	y17 = BS_XOR(y10, y11);
+	y19 = BS_XOR(y10, y8);
+	y16 = BS_XOR(t0, y11);
+	y21 = BS_XOR(y13, y16);
+	y18 = BS_XOR(x0, y16);
+
+	// non-linear section, inversion in GF(2^8)
+	t2 = BS_AND(y12, y15);
+	t3 = BS_AND(y3, y6);
+	t4 = BS_XOR(t3, t2);
+	t5 = BS_AND(y4, x7);
+	t6 = BS_XOR(t5, t2);
+	t7 = BS_AND(y13, y16);
+	t8 = BS_AND(y5, y1);
+	t9 = BS_XOR(t8, t7);
+	t10 = BS_AND(y2, y7);
+	t11 = BS_XOR(t10, t7);
+	t12 = BS_AND(y9, y11);
+	t13 = BS_AND(y14, y17);
+	t14 = BS_XOR(t13, t12);
+	t15 = BS_AND(y8, y10);
+	t16 = BS_XOR(t15, t12);
+	t17 = BS_XOR(t4, t14);
+	t18 = BS_XOR(t6, t16);
+	t19 = BS_XOR(t9, t14);
+	t20 = BS_XOR(t11, t16);
+	t21 = BS_XOR(t17, y20);
+	t22 = BS_XOR(t18, y19);
+	t23 = BS_XOR(t19, y21);
+	t24 = BS_XOR(t20, y18);
+
+	t25 = BS_XOR(t21, t22);
+	t26 = BS_AND(t21, t23);
+	t27 = BS_XOR(t24, t26);
+	t28 = BS_AND(t25, t27);
+	t29 = BS_XOR(t28, t22);
+	t30 = BS_XOR(t23, t24);
+	t31 = BS_XOR(t22, t26);
+	t32 = BS_AND(t31, t30);
+	t33 = BS_XOR(t32, t24);
+	t34 = BS_XOR(t23, t33);
+	t35 = BS_XOR(t27, t33);
+	t36 = BS_AND(t24, t35);
+	t37 = BS_XOR(t36, t34);
+	t38 = BS_XOR(t27, t36);
+	t39 = BS_AND(t29, t38);
+	t40 = BS_XOR(t25, t39);
+
+	t41 = BS_XOR(t40, t37);
+	t42 = BS_XOR(t29, t33);
+	t43 = BS_XOR(t29, t40);
+	t44 = BS_XOR(t33, t37);
+	t45 = BS_XOR(t42, t41);
+	z0 = BS_AND(t44, y15);
+	z1 = BS_AND(t37, y6);
+	z2 = BS_AND(t33, x7);
+	z3 = BS_AND(t43, y16);
+	z4 = BS_AND(t40, y1);
+	z5 = BS_AND(t29, y7);
+	z6 = BS_AND(t42, y11);
+	z7 = BS_AND(t45, y17);
+	z8 = BS_AND(t41, y10);
+	z9 = BS_AND(t44, y12);
+	z10 = BS_AND(t37, y3);
+	z11 = BS_AND(t33, y4);
+	z12 = BS_AND(t43, y13);
+	z13 = BS_AND(t40, y5);
+	z14 = BS_AND(t29, y2);
+	z15 = BS_AND(t42, y9);
+	z16 = BS_AND(t45, y14);
+	z17 = BS_AND(t41, y8);
+
+	// bottom linear transformation
+	t46 = BS_XOR(z15, z16);
+	t47 = BS_XOR(z10, z11);
+	t48 = BS_XOR(z5, z13);
+	t49 = BS_XOR(z9, z10);
+	t50 = BS_XOR(z2, z12);
+	t51 = BS_XOR(z2, z5);
+	t52 = BS_XOR(z7, z8);
+	t53 = BS_XOR(z0, z3);
+	t54 = BS_XOR(z6, z7);
+	t55 = BS_XOR(z16, z17);
+	t56 = BS_XOR(z12, t48);
+	t57 = BS_XOR(t50, t53);
+	t58 = BS_XOR(z4, t46);
+	t59 = BS_XOR(z3, t54);
+	t60 = BS_XOR(t46, t57);
+	t61 = BS_XOR(z14, t57);
+	t62 = BS_XOR(t52, t58);
+	t63 = BS_XOR(t49, t58);
+	t64 = BS_XOR(z4, t59);
+	t65 = BS_XOR(t61, t62);
+	t66 = BS_XOR(z1, t63);
+	s0 = BS_XOR(t59, t63);
+	s6 = BS_XOR(t56, BS_NOT(t62));
+	s7 = BS_XOR(t48, BS_NOT(t60));
+	t67 = BS_XOR(t64, t65);
+	s3 = BS_XOR(t53, t66);
+	s4 = BS_XOR(t51, t66);
+	s5 = BS_XOR(t47, t65);
+	s1 = BS_XOR(t64, BS_NOT(s3));
+	s2 = BS_XOR(t55, BS_NOT(t67));
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+/****************************************************************************************
+ * @brief Inverse affine transform of the S-box, applied before and after bs_sbox()
+ ***************************************************************************************/
+static void bs_inv_affine(bs_t *q) {
+	bs_t q0 = BS_NOT(q[0]);
+	bs_t q1 = BS_NOT(q[1]);
+	bs_t q2 = q[2];
+	bs_t q3 = q[3];
+	bs_t q4 = q[4];
+	bs_t q5 = BS_NOT(q[5]);
+	bs_t q6 = BS_NOT(q[6]);
+	bs_t q7 = q[7];
+
+	q[7] = BS_XOR(BS_XOR(q1, q4), q6);
+	q[6] = BS_XOR(BS_XOR(q0, q3), q5);
+	q[5] = BS_XOR(BS_XOR(q7, q2), q4);
+	q[4] = BS_XOR(BS_XOR(q6, q1), q3);
+	q[3] = BS_XOR(BS_XOR(q5, q0), q2);
+	q[2] = BS_XOR(BS_XOR(q4, q7), q1);
+	q[1] = BS_XOR(BS_XOR(q3, q6), q0);
+	q[0] = BS_XOR(BS_XOR(q2, q5), q7);
+}
+
+static void bs_inv_sbox(bs_t *q) {
+	bs_inv_affine(q);
+	bs_sbox(q);
+	bs_inv_affine(q);
+}
+
+static void bs_shift_rows(bs_t *q) {
+	for (int i = 0; i < 8; i++) {
+		bs_t x = q[i];
+		q[i] = BS_OR(BS_OR(BS_OR(BS_MASK(x, 0x000000000000FFFFull),
+		                         BS_SHR(BS_MASK(x, 0x00000000FFF00000ull), 4)),
+		                   BS_OR(BS_SHL(BS_MASK(x, 0x00000000000F0000ull), 12),
+		                         BS_SHR(BS_MASK(x, 0x0000FF0000000000ull), 8))),
+		             BS_OR(BS_OR(BS_SHL(BS_MASK(x, 0x000000FF00000000ull), 8),
+		                         BS_SHR(BS_MASK(x, 0xF000000000000000ull), 12)),
+		                   BS_SHL(BS_MASK(x, 0x0FFF000000000000ull), 4)));
+	}
+}
+
+static void bs_inv_shift_rows(bs_t *q) {
+	for (int i = 0; i < 8; i++) {
+		bs_t x = q[i];
+		q[i] = BS_OR(BS_OR(BS_OR(BS_MASK(x, 0x000000000000FFFFull),
+		                         BS_SHL(BS_MASK(x, 0x000000000FFF0000ull), 4)),
+		                   BS_OR(BS_SHR(BS_MASK(x, 0x00000000F0000000ull), 12),
+		                         BS_SHL(BS_MASK(x, 0x000000FF00000000ull), 8))),
+		             BS_OR(BS_OR(BS_SHR(BS_MASK(x, 0x0000FF0000000000ull), 8),
+		                         BS_SHL(BS_MASK(x, 0x000F000000000000ull), 12)),
+		                   BS_SHR(BS_MASK(x, 0xFFF0000000000000ull), 4)));
+	}
+}
+
+static void bs_mix_columns(bs_t *q) {
+	bs_t r[8];
+	bs_t q7r7;
+
+	for (int i = 0; i < 8; i++) {
+		r[i] = BS_ROTR16(q[i]);
+	}
+	q7r7 = BS_XOR(q[7], r[7]);
+
+	bs_t n0 = BS_XOR(BS_XOR(q7r7, r[0]), BS_ROTR32(BS_XOR(q[0], r[0])));
+	bs_t n1 = BS_XOR(BS_XOR(BS_XOR(q[0], r[0]), BS_XOR(q7r7, r[1])), BS_ROTR32(BS_XOR(q[1], r[1])));
+	bs_t n2 = BS_XOR(BS_XOR(BS_XOR(q[1], r[1]), r[2]), BS_ROTR32(BS_XOR(q[2], r[2])));
+	bs_t n3 = BS_XOR(BS_XOR(BS_XOR(q[2], r[2]), BS_XOR(q7r7, r[3])), BS_ROTR32(BS_XOR(q[3], r[3])));
+	bs_t n4 = BS_XOR(BS_XOR(BS_XOR(q[3], r[3]), BS_XOR(q7r7, r[4])), BS_ROTR32(BS_XOR(q[4], r[4])));
+	bs_t n5 = BS_XOR(BS_XOR(BS_XOR(q[4], r[4]), r[5]), BS_ROTR32(BS_XOR(q[5], r[5])));
+	bs_t n6 = BS_XOR(BS_XOR(BS_XOR(q[5], r[5]), r[6]), BS_ROTR32(BS_XOR(q[6], r[6])));
+	bs_t n7 = BS_XOR(BS_XOR(BS_XOR(q[6], r[6]), r[7]), BS_ROTR32(q7r7));
+
+	q[0] = n0; q[1] = n1; q[2] = n2; q[3] = n3;
+	q[4] = n4; q[5] = n5; q[6] = n6; q[7] = n7;
+}
+
+/****************************************************************************************
+ * @brief InvMixColumns, multiplication by {0e,0b,0d,09}
+ ***************************************************************************************/
+static void bs_inv_mix_columns(bs_t *q) {
+	bs_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+	bs_t q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+	bs_t r0 = BS_ROTR16(q0), r1 = BS_ROTR16(q1), r2 = BS_ROTR16(q2), r3 = BS_ROTR16(q3);
+	bs_t r4 = BS_ROTR16(q4), r5 = BS_ROTR16(q5), r6 = BS_ROTR16(q6), r7 = BS_ROTR16(q7);
+
+#define X3(a, b, c)		BS_XOR(BS_XOR(a, b), c)
+#define X4(a, b, c, d)		BS_XOR(BS_XOR(a, b), BS_XOR(c, d))
+#define X5(a, b, c, d, e)	BS_XOR(X4(a, b, c, d), e)
+	q[0] = BS_XOR(BS_XOR(X3(q5, q6, q7), X3(r0, r5, r7)),
+	              BS_ROTR32(X5(q0, q5, q6, r0, r5)));
+	q[1] = BS_XOR(BS_XOR(X3(q0, q5, r0), BS_XOR(X3(r1, r5, r6), r7)),
+	              BS_ROTR32(BS_XOR(X3(q1, q5, q7), X3(r1, r5, r6))));
+	q[2] = BS_XOR(BS_XOR(X3(q0, q1, q6), BS_XOR(X3(r1, r2, r6), r7)),
+	              BS_ROTR32(BS_XOR(X3(q0, q2, q6), X3(r2, r6, r7))));
+	q[3] = BS_XOR(BS_XOR(X5(q0, q1, q2, q5, q6), X4(r0, r2, r3, r5)),
+	              BS_ROTR32(BS_XOR(X5(q0, q1, q3, q5, q6), X5(q7, r0, r3, r5, r7))));
+	q[4] = BS_XOR(BS_XOR(X5(q1, q2, q3, q5, r1), X5(r3, r4, r5, r6, r7)),
+	              BS_ROTR32(BS_XOR(X5(q1, q2, q4, q5, q7), X4(r1, r4, r5, r6))));
+	q[5] = BS_XOR(BS_XOR(X5(q2, q3, q4, q6, r2), X4(r4, r5, r6, r7)),
+	              BS_ROTR32(BS_XOR(X5(q2, q3, q5, q6, r2), X3(r5, r6, r7))));
+	q[6] = BS_XOR(BS_XOR(X5(q3, q4, q5, q7, r3), X3(r5, r6, r7)),
+	              BS_ROTR32(BS_XOR(X5(q3, q4, q6, q7, r3), BS_XOR(r6, r7))));
+	q[7] = BS_XOR(BS_XOR(X3(q4, q5, q6), X3(r4, r6, r7)),
+	              BS_ROTR32(X5(q4, q5, q7, r4, r7)));
+#undef X3
+#undef X4
+#undef X5
+}
+
+/****************************************************************************************
+ * @brief Expand one compressed round key and add it to the state
+ ***************************************************************************************/
+static void bs_add_round_key(bs_t *q, const uint64_t *comp_key) {
+	for (int h = 0; h < 2; h++) {
+		uint64_t x0, x1, x2, x3;
+
+		x0 = x1 = x2 = x3 = comp_key[h];
+		x0 &= 0x1111111111111111ull;
+		x1 &= 0x2222222222222222ull;
+		x2 &= 0x4444444444444444ull;
+		x3 &= 0x8888888888888888ull;
+		x1 >>= 1;
+		x2 >>= 2;
+		x3 >>= 3;
+		q[4*h + 0] = BS_XOR(q[4*h + 0], BS_DUP((x0 << 4) - x0));
+		q[4*h + 1] = BS_XOR(q[4*h + 1], BS_DUP((x1 << 4) - x1));
+		q[4*h + 2] = BS_XOR(q[4*h + 2], BS_DUP((x2 << 4) - x2));
+		q[4*h + 3] = BS_XOR(q[4*h + 3], BS_DUP((x3 << 4) - x3));
+	}
+}
+
+/****************************************************************************************
+ * @brief Add round key u from a merged key set (see AES_BS_set_lane_key())
+ ***************************************************************************************/
+static void bs_add_merged_key(bs_t *q, const uint64_t *merged, unsigned u) {
+	const uint64_t *k = merged + 16*u;
+
+	for (int p = 0; p < 8; p++) {
+		q[p] = BS_XOR(q[p], BS_SET(k[2*p], k[2*p + 1]));
+	}
+}
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Convert the expanded key of aes.c to the compressed bitsliced form
+ * @param comp_key[out]	AES_BS_KEYWORDS(Nr) words
+ * @param RoundKey[in]	Expanded key, 16 * (Nr + 1) bytes
+ * @param Nr[in]		Number of rounds (10, 12 or 14)
+ ***************************************************************************************/
+void AES_BS_compress_key(uint64_t* comp_key, const uint8_t* RoundKey, unsigned Nr) {
+	for (unsigned i = 0; i <= Nr; i++) {
+		uint32_t w[4];
+		uint64_t q[8];
+
+		for (int j = 0; j < 4; j++) {
+			w[j] = bs_dec32le(RoundKey + 16*i + 4*j);
+		}
+		bs_interleave_in(&q[0], &q[4], w);
+		q[1] = q[2] = q[3] = q[0];
+		q[5] = q[6] = q[7] = q[4];
+
+		/* ortho on scalar words, the key is identical in all lanes */
+		bs_t v[8];
+		for (int j = 0; j < 8; j++) {
+			v[j] = BS_DUP(q[j]);
+		}
+		bs_ortho(v);
+		for (int j = 0; j < 8; j++) {
+			q[j] = BS_LO(v[j]);
+		}
+
+		comp_key[2*i + 0] = (q[0] & 0x1111111111111111ull) | (q[1] & 0x2222222222222222ull)
+		                  | (q[2] & 0x4444444444444444ull) | (q[3] & 0x8888888888888888ull);
+		comp_key[2*i + 1] = (q[4] & 0x1111111111111111ull) | (q[5] & 0x2222222222222222ull)
+		                  | (q[6] & 0x4444444444444444ull) | (q[7] & 0x8888888888888888ull);
+	}
+}
+
+/****************************************************************************************
+ * @brief Encrypt 8 consecutive blocks in place (ECB)
+ * @param comp_key[in]	Compressed round keys from AES_BS_compress_key()
+ * @param Nr[in]		Number of rounds
+ * @param blocks[in,out]	AES_BS_BLOCKS * 16 bytes
+ ***************************************************************************************/
+void AES_BS_encrypt8(const uint64_t* comp_key, unsigned Nr, uint8_t* blocks) {
+	bs_t q[8];
+
+	bs_load(q, blocks);
+	bs_add_round_key(q, comp_key);
+	for (unsigned u = 1; u < Nr; u++) {
+		bs_sbox(q);
+		bs_shift_rows(q);
+		bs_mix_columns(q);
+		bs_add_round_key(q, comp_key + 2*u);
+	}
+	bs_sbox(q);
+	bs_shift_rows(q);
+	bs_add_round_key(q, comp_key + 2*Nr);
+	bs_store(blocks, q);
+}
+
+/****************************************************************************************
+ * @brief Load the key of one block position into a merged key set
+ *
+ * Within a lane the 4 blocks interleave nibble-wise: block b owns bit b of every
+ * nibble of every bit plane. Plane p of block b's key is therefore bit p of each
+ * nibble of its compressed key word, moved to bit position b. Only the bits of the
+ * given position change, so a lane can be rekeyed while the others keep their key.
+ *
+ * @param merged[in,out]	AES_BS_MERGED_WORDS(Nr) words
+ * @param lane[in]		Block position 0..AES_BS_BLOCKS-1
+ * @param comp_key[in]	Compressed round keys from AES_BS_compress_key()
+ * @param Nr[in]		Number of rounds
+ ***************************************************************************************/
+void AES_BS_set_lane_key(uint64_t* merged, unsigned lane, const uint64_t* comp_key, unsigned Nr) {
+	const unsigned l = lane / 4;
+	const unsigned b = lane % 4;
+	const uint64_t mask = 0x1111111111111111ull << b;
+
+	for (unsigned u = 0; u <= Nr; u++) {
+		for (unsigned h = 0; h < 2; h++) {
+			for (unsigned p = 0; p < 4; p++) {
+				uint64_t *k = &merged[16*u + 2*(4*h + p) + l];
+				uint64_t v = ((comp_key[2*u + h] >> p) & 0x1111111111111111ull) << b;
+				*k = (*k & ~mask) | v;
+			}
+		}
+	}
+}
+
+/****************************************************************************************
+ * @brief Encrypt 8 independent blocks in place, each with the key of its position
+ * @param merged[in]		Key set built with AES_BS_set_lane_key()
+ * @param Nr[in]			Number of rounds
+ * @param blocks[in,out]	AES_BS_BLOCKS * 16 bytes
+ ***************************************************************************************/
+void AES_BS_encrypt8_merged(const uint64_t* merged, unsigned Nr, uint8_t* blocks) {
+	bs_t q[8];
+
+	bs_load(q, blocks);
+	bs_add_merged_key(q, merged, 0);
+	for (unsigned u = 1; u < Nr; u++) {
+		bs_sbox(q);
+		bs_shift_rows(q);
+		bs_mix_columns(q);
+		bs_add_merged_key(q, merged, u);
+	}
+	bs_sbox(q);
+	bs_shift_rows(q);
+	bs_add_merged_key(q, merged, Nr);
+	bs_store(blocks, q);
+}
+
+/****************************************************************************************
+ * @brief Decrypt 8 consecutive blocks in place (ECB)
+ * @param comp_key[in]	Compressed round keys from AES_BS_compress_key()
+ * @param Nr[in]		Number of rounds
+ * @param blocks[in,out]	AES_BS_BLOCKS * 16 bytes
+ ***************************************************************************************/
+void AES_BS_decrypt8(const uint64_t* comp_key, unsigned Nr, uint8_t* blocks) {
+	bs_t q[8];
+
+	bs_load(q, blocks);
+	bs_add_round_key(q, comp_key + 2*Nr);
+	for (unsigned u = Nr - 1; u > 0; u--) {
+		bs_inv_shift_rows(q);
+		bs_inv_sbox(q);
+		bs_add_round_key(q, comp_key + 2*u);
+		bs_inv_mix_columns(q);
+	}
+	bs_inv_shift_rows(q);
+	bs_inv_sbox(q);
+	bs_add_round_key(q, comp_key);
+	bs_store(blocks, q);
+}
+
+/****************************************************************************************
+ * @brief Apply the S-box to the 4 bytes of a key schedule word
+ *
+ * One word through the bitsliced S-box, so the key expansion does not index a table
+ * with key bytes either. The other byte positions of the call are padding.
+ *
+ * @param word[in,out]	4 bytes
+ ***************************************************************************************/
+void AES_BS_sub_word(uint8_t* word) {
+	uint8_t blocks[AES_BS_BLOCKS * 16] = { 0 };
+	bs_t q[8];
+
+	for (int i = 0; i < 4; i++) {
+		blocks[i] = word[i];
+	}
+	bs_load(q, blocks);
+	bs_sbox(q);
+	bs_store(blocks, q);
+	for (int i = 0; i < 4; i++) {
+		word[i] = blocks[i];
+	}
+}
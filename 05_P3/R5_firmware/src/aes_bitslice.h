@@ -0,0 +1,31 @@
+/****************************************************************************************
+ * @file
+ * @brief See aes_bitslice.c
+ ***************************************************************************************/
+
+#ifndef AES_BITSLICE_H
+#define AES_BITSLICE_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define AES_BS_BLOCKS			(8)						// blocks per kernel call
+#define AES_BS_KEYWORDS(Nr)		(((Nr) + 1) * 2)		// compressed round key words
+#define AES_BS_MERGED_WORDS(Nr)	(((Nr) + 1) * 16)		// one key per block position
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+void AES_BS_compress_key(uint64_t* comp_key, const uint8_t* RoundKey, unsigned Nr);
+void AES_BS_encrypt8(const uint64_t* comp_key, unsigned Nr, uint8_t* blocks);
+void AES_BS_set_lane_key(uint64_t* merged, unsigned lane, const uint64_t* comp_key, unsigned Nr);
+void AES_BS_encrypt8_merged(const uint64_t* merged, unsigned Nr, uint8_t* blocks);
+void AES_BS_decrypt8(const uint64_t* comp_key, unsigned Nr, uint8_t* blocks);
+void AES_BS_sub_word(uint8_t* word);
+
+#endif  /* AES_BITSLICE_H */
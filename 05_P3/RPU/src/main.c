@@ -17,6 +17,7 @@
 #include <string.h>
 #include <time.h>
 #include "aes_rpu.h"
+#include "timing.h"
 
 
 /****************************************************************************************
@@ -88,25 +89,33 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    struct timespec time_start, time_stop;
-    float time;
+    timing_run_t run;
+    int ok;
 
-    printf("\nTesting AES256\n");
+    printf("\nTesting AES256 (build: %s)\n", BUILD_TYPE);
 
-    // TODO geeignete Zeitmessung einbauen
+    TIMING_init(&run);
 
+    // the key travels with every request, there is no separate key setup
+    TIMING_begin(&run, TIMING_START);
     int success = AES_RPU_start("aes_rpu_rtos.elf");
+    TIMING_end(&run, TIMING_START);
     if (0 > success) {
         perror("AES RPU startup failed. exit program.\n");
         return 2;
     }
 
-    clock_gettime(CLOCK_REALTIME, &time_start);
+    TIMING_begin(&run, TIMING_ENCRYPT);
     AES_RPU_encrypt_buffer(key, iv, enc_a, text_length);
-    clock_gettime(CLOCK_REALTIME, &time_stop);
+    TIMING_end(&run, TIMING_ENCRYPT);
 
+    TIMING_begin(&run, TIMING_DECRYPT);
     AES_RPU_decrypt_buffer(key, iv, dec_a, text_length);
+    TIMING_end(&run, TIMING_DECRYPT);
+
+    TIMING_begin(&run, TIMING_TEARDOWN);
     success = AES_RPU_stop("aes_rpu_rtos.elf");
+    TIMING_end(&run, TIMING_TEARDOWN);
     if (0 > success) {
         perror("AES RPU stop failed. exit program.\n");
         return 3;
@@ -120,7 +129,8 @@ int main(int argc, char *argv[]) {
     printf("\n");
 
     printf("AES encrypt: ");
-    if (0 == memcmp((char*) enc_t, (char*) enc_a, text_length)) {
+    ok = (0 == memcmp((char*) enc_t, (char*) enc_a, text_length));
+    if (ok) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
@@ -132,12 +142,17 @@ int main(int argc, char *argv[]) {
     printf("Soll: "); print_hex(dec_t, text_length);
     printf("\n");
 
-    
-    time = (time_stop.tv_sec + time_stop.tv_nsec*1e-9)
-         - (time_start.tv_sec + time_start.tv_nsec*1e-9);
+    printf("AES decrypt: ");
+    if (0 == memcmp((char*) dec_t, (char*) dec_a, text_length)) {
+        printf("SUCCESS!\n");
+    } else {
+        printf("FAILURE!\n");
+        ok = 0;
+    }
 
-    printf("Time: %.2f ms\n",time*1000);
-    printf("Size: %li\n",text_length);
+    printf("\nMeasurement per phase; Message size %zu Bytes\n", text_length);
+    TIMING_print(&run);
+    TIMING_print_json(&run, "rpu", text_length, ok);
 
     return 0;
 }
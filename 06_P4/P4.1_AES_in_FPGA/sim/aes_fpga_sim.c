@@ -0,0 +1,308 @@
+/****************************************************************************************
+ * @file
+ * @brief Host-side register model of the FPGA AES block
+ *
+ * @note The model implements the register map of aes_fpga_regs.h on top of the
+ * software AES core (aes.c of 05_P3/RPU, see SIM_AES_DIR in the Makefile), so the
+ * driver can be developed, tested and benchmarked without the board. It is selected by building with AES_FPGA_SIM (make sim).
+ *
+ * Behaviour of the model:
+ * - Writing INIT to the control register expands the key and clears READY and VALID.
+ *   READY is set again after the configured latency.
+ * - Writing NEXT processes the block and IV registers with the configured direction:
+ *   encrypt RESULT = E(BLOCK ^ IV), decrypt RESULT = D(BLOCK) ^ IV. The result
+ *   registers are updated and VALID is set after the configured latency.
+ * - The core consumes each 32-bit bus word least significant byte first, which is
+ *   the order the driver produces with native stores of a byte buffer.
+ *
+ * The default latency can be overridden with the environment variables
+ * AES_FPGA_SIM_READY_POLLS, AES_FPGA_SIM_VALID_POLLS, AES_FPGA_SIM_READY_NS and
+ * AES_FPGA_SIM_VALID_NS, so main.c runs unchanged against different timings.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aes.h"
+#include "aes_fpga_regs.h"
+#include "aes_fpga_sim.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define SIM_KEY_WORDS			(8)
+#define SIM_BLOCK_WORDS			(4)
+
+#define SIM_DEFAULT_READY_POLLS	(4)
+#define SIM_DEFAULT_VALID_POLLS	(2)
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+typedef struct {
+	int busy;					// operation in flight
+	uint32_t polls;				// status reads since start
+	uint64_t start_ns;			// start of the operation
+} sim_op_t;
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+static uint32_t regs[AES_REG_COUNT];
+static uint32_t result[SIM_BLOCK_WORDS];
+static uint32_t status;
+static uint32_t config;
+
+static struct AES_ctx ctx;
+static sim_op_t init_op;
+static sim_op_t next_op;
+
+static aes_fpga_sim_latency_t latency = {
+	.ready_polls = SIM_DEFAULT_READY_POLLS,
+	.valid_polls = SIM_DEFAULT_VALID_POLLS,
+	.ready_ns = 0,
+	.valid_ns = 0
+};
+static aes_fpga_sim_stats_t stats;
+static int env_loaded;
+
+/****************************************************************************************
+ * Local Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Monotonic time in nanoseconds
+ ***************************************************************************************/
+static uint64_t sim_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/****************************************************************************************
+ * @brief Read an unsigned value from the environment, keep default if not set
+ ***************************************************************************************/
+static void sim_env_u64(const char *name, uint64_t *value) {
+	const char *s = getenv(name);
+	if (s != NULL && *s != '\0') {
+		*value = strtoull(s, NULL, 0);
+	}
+}
+
+static void sim_env_u32(const char *name, uint32_t *value) {
+	uint64_t v = *value;
+	sim_env_u64(name, &v);
+	*value = (uint32_t)v;
+}
+
+/****************************************************************************************
+ * @brief Serialize bus words to the byte stream seen by the AES core
+ ***************************************************************************************/
+static void sim_words_to_bytes(const uint32_t *words, uint8_t *bytes, size_t n_words) {
+	for (size_t i = 0; i < n_words; i++) {
+		bytes[4*i + 0] = (uint8_t)(words[i]);
+		bytes[4*i + 1] = (uint8_t)(words[i] >> 8);
+		bytes[4*i + 2] = (uint8_t)(words[i] >> 16);
+		bytes[4*i + 3] = (uint8_t)(words[i] >> 24);
+	}
+}
+
+static void sim_bytes_to_words(const uint8_t *bytes, uint32_t *words, size_t n_words) {
+	for (size_t i = 0; i < n_words; i++) {
+		words[i] = (uint32_t)bytes[4*i + 0]
+		         | (uint32_t)bytes[4*i + 1] << 8
+		         | (uint32_t)bytes[4*i + 2] << 16
+		         | (uint32_t)bytes[4*i + 3] << 24;
+	}
+}
+
+/****************************************************************************************
+ * @brief Report an access the hardware would not accept
+ ***************************************************************************************/
+static void sim_protocol_error(const char *what) {
+	stats.protocol_errors++;
+	fprintf(stderr, "AES_FPGA_SIM: %s\n", what);
+}
+
+/****************************************************************************************
+ * @brief Check whether an operation has reached its latency
+ ***************************************************************************************/
+static int sim_op_done(sim_op_t *op, uint32_t polls, uint64_t ns) {
+	op->polls++;
+	return (op->polls >= polls) && (sim_now_ns() - op->start_ns >= ns);
+}
+
+static void sim_op_start(sim_op_t *op) {
+	op->busy = 1;
+	op->polls = 0;
+	op->start_ns = sim_now_ns();
+}
+
+/****************************************************************************************
+ * @brief Key expansion triggered by INIT
+ ***************************************************************************************/
+static void sim_init(void) {
+	uint8_t key[SIM_KEY_WORDS * 4];
+
+	stats.key_expansions++;
+	if (((config >> CONFIG_KEYLEN_BIT) & 1u) != AES_256_BIT_KEY) {
+		sim_protocol_error("only 256-bit keys are modelled");
+	}
+
+	sim_words_to_bytes(&regs[AES_KEY_REG(0)], key, SIM_KEY_WORDS);
+	AES_init_ctx(&ctx, key);
+
+	status &= ~((1u << STATUS_READY_BIT) | (1u << STATUS_VALID_BIT));
+	next_op.busy = 0;
+	sim_op_start(&init_op);
+}
+
+/****************************************************************************************
+ * @brief Block processing triggered by NEXT
+ ***************************************************************************************/
+static void sim_next(void) {
+	uint8_t block[AES_BLOCKLEN];
+	uint8_t iv[AES_BLOCKLEN];
+
+	stats.blocks++;
+	if ((status & (1u << STATUS_READY_BIT)) == 0) {
+		sim_protocol_error("NEXT before READY");
+		return;
+	}
+
+	sim_words_to_bytes(&regs[AES_BLOCK_REG(0)], block, SIM_BLOCK_WORDS);
+	sim_words_to_bytes(&regs[AES_IV_REG(0)], iv, SIM_BLOCK_WORDS);
+
+	if (((config >> CONFIG_ENCDEC_BIT) & 1u) == AES_ENC) {
+		for (int i = 0; i < AES_BLOCKLEN; i++) block[i] ^= iv[i];
+		AES_ECB_encrypt(&ctx, block);
+	} else {
+		AES_ECB_decrypt(&ctx, block);
+		for (int i = 0; i < AES_BLOCKLEN; i++) block[i] ^= iv[i];
+	}
+
+	sim_bytes_to_words(block, result, SIM_BLOCK_WORDS);
+	status &= ~(1u << STATUS_VALID_BIT);
+	sim_op_start(&next_op);
+}
+
+/****************************************************************************************
+ * @brief Status register read, advances in-flight operations
+ ***************************************************************************************/
+static uint32_t sim_status(void) {
+	stats.status_polls++;
+
+	if (init_op.busy && sim_op_done(&init_op, latency.ready_polls, latency.ready_ns)) {
+		init_op.busy = 0;
+		status |= (1u << STATUS_READY_BIT);
+	}
+	if (next_op.busy && sim_op_done(&next_op, latency.valid_polls, latency.valid_ns)) {
+		next_op.busy = 0;
+		memcpy(&regs[AES_RESULT_REG(0)], result, sizeof(result));
+		status |= (1u << STATUS_VALID_BIT);
+	}
+	return status;
+}
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Stand-in for the /dev/mem mapping of the register block
+ * @return Pointer to the register file of the model
+ ***************************************************************************************/
+volatile uint32_t *AES_FPGA_SIM_map(void) {
+	if (!env_loaded) {
+		env_loaded = 1;
+		sim_env_u32("AES_FPGA_SIM_READY_POLLS", &latency.ready_polls);
+		sim_env_u32("AES_FPGA_SIM_VALID_POLLS", &latency.valid_polls);
+		sim_env_u64("AES_FPGA_SIM_READY_NS", &latency.ready_ns);
+		sim_env_u64("AES_FPGA_SIM_VALID_NS", &latency.valid_ns);
+	}
+	return regs;
+}
+
+/****************************************************************************************
+ * @brief Reset the model to power-on state and clear the counters
+ ***************************************************************************************/
+void AES_FPGA_SIM_reset(void) {
+	memset(regs, 0, sizeof(regs));
+	memset(result, 0, sizeof(result));
+	memset(&stats, 0, sizeof(stats));
+	memset(&init_op, 0, sizeof(init_op));
+	memset(&next_op, 0, sizeof(next_op));
+	status = 0;
+	config = 0;
+}
+
+/****************************************************************************************
+ * @brief Set the READY/VALID latency of the model
+ * @param new_latency[in]	New latency
+ ***************************************************************************************/
+void AES_FPGA_SIM_set_latency(const aes_fpga_sim_latency_t *new_latency) {
+	latency = *new_latency;
+	env_loaded = 1;
+}
+
+/****************************************************************************************
+ * @brief Get the access counters
+ * @param out[out]	Counters since the last reset
+ ***************************************************************************************/
+void AES_FPGA_SIM_get_stats(aes_fpga_sim_stats_t *out) {
+	*out = stats;
+}
+
+/****************************************************************************************
+ * @brief Register read
+ * @param reg[in]	Word index of the register
+ * @return Register value, write-only registers read as 0
+ ***************************************************************************************/
+uint32_t AES_FPGA_SIM_read(uint32_t reg) {
+	stats.reg_reads++;
+
+	if (reg == AES_STATUS_REG) {
+		return sim_status();
+	}
+	if (reg >= AES_RESULT_REG(0) && reg <= AES_RESULT_REG(3)) {
+		return regs[reg];
+	}
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Register write
+ * @param reg[in]	Word index of the register
+ * @param value[in]	Value to write
+ ***************************************************************************************/
+void AES_FPGA_SIM_write(uint32_t reg, uint32_t value) {
+	stats.reg_writes++;
+
+	if (reg >= AES_REG_COUNT || reg == AES_STATUS_REG
+	    || (reg >= AES_RESULT_REG(0) && reg <= AES_RESULT_REG(3))) {
+		sim_protocol_error("write to read-only or unmapped register");
+		return;
+	}
+
+	switch (reg) {
+	case AES_CONFIG_REG:
+		config = value;
+		break;
+	case AES_CTRL_REG:
+		if (value == (1u << CTRL_INIT_BIT)) {
+			sim_init();
+		} else if (value == (1u << CTRL_NEXT_BIT)) {
+			sim_next();
+		} else if (value != 0) {
+			sim_protocol_error("control register: set exactly one of INIT/NEXT");
+		}
+		break;
+	default:
+		regs[reg] = value;
+		break;
+	}
+}
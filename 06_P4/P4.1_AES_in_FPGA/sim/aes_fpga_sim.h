@@ -0,0 +1,46 @@
+/****************************************************************************************
+ * @file
+ * @brief See aes_fpga_sim.c
+ ***************************************************************************************/
+
+#ifndef AES_FPGA_SIM_H
+#define AES_FPGA_SIM_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+
+/* Latency of the modelled core. A status bit is set once both limits are reached. */
+typedef struct {
+	uint32_t ready_polls;		// status reads after INIT until READY is set
+	uint32_t valid_polls;		// status reads after NEXT until VALID is set
+	uint64_t ready_ns;			// minimum time after INIT until READY is set
+	uint64_t valid_ns;			// minimum time after NEXT until VALID is set
+} aes_fpga_sim_latency_t;
+
+/* Access counters, used to check chaining, key caching and batching in the driver */
+typedef struct {
+	uint32_t reg_reads;
+	uint32_t reg_writes;
+	uint32_t status_polls;
+	uint32_t key_expansions;	// INIT requests
+	uint32_t blocks;			// NEXT requests
+	uint32_t protocol_errors;	// accesses the hardware would not accept
+} aes_fpga_sim_stats_t;
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+volatile uint32_t *AES_FPGA_SIM_map(void);
+void AES_FPGA_SIM_reset(void);
+void AES_FPGA_SIM_set_latency(const aes_fpga_sim_latency_t *latency);
+void AES_FPGA_SIM_get_stats(aes_fpga_sim_stats_t *stats);
+uint32_t AES_FPGA_SIM_read(uint32_t reg);
+void AES_FPGA_SIM_write(uint32_t reg, uint32_t value);
+
+#endif  /* AES_FPGA_SIM_H */
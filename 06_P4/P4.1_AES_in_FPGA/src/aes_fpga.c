@@ -28,32 +28,12 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include "aes_fpga.h"
+#include "aes_fpga_regs.h"
+#include "aes_fpga_io.h"
 
 /****************************************************************************************
  * Defines
  ***************************************************************************************/
-#define AES_BASE_ADDR		(0x80020000)	//system.dts apb@80020000
-
-#define AES_CTRL_REG			(0x08)			//control register
-#define AES_STATUS_REG			(0x09)			//status register
-#define AES_CONFIG_REG			(0x0a)			//config register
-#define AES_KEY_REG(X)			(0x10+X)		//..0x17 key register for each 32bit data
-#define AES_BLOCK_REG(X)		(0x20+X)		//..0x23 block register
-#define AES_RESULT_REG(X)		(0x30+X)		//..0x33 result register
-#define AES_IV_REG(X)			(0x40+X)		//..0x43 initialization vector register
-
-#define CTRL_INIT_BIT			(0)
-#define CTRL_NEXT_BIT			(1)
-#define CONFIG_ENCDEC_BIT		(0)
-#define CONFIG_KEYLEN_BIT		(1)
-#define STATUS_READY_BIT		(0)
-#define STATUS_VALID_BIT		(1)
-
-#define AES_128_BIT_KEY			(0)
-#define AES_256_BIT_KEY			(1)
-#define AES_ENC					(1)
-#define AES_DEC					(0)
-
 #define KEY_SIZE				(32)
 #define IV_SIZE					(16)
 
@@ -61,55 +41,68 @@
 #define CHAR_SIZE_IN_BITS		(8)
 #define DATA_BUS_SIZE			(DATA_BUS_SIZE_IN_BITS/CHAR_SIZE_IN_BITS)
 
-static void *virtual_aes_base;
+static volatile uint32_t *virtual_aes_base;
 
 /****************************************************************************************
  * Local Functions
  ***************************************************************************************/
 
 /****************************************************************************************
- * @brief engine-based AES encryption
- * @param enc[in]		Set 1 for encryption
- * @param key[in]		Key
- * @param iv[in]		Initialization vector
- * @param buf[in/out]	Plain/Cipher text
- * @param length[in]	Length of text (must be divisible by 16byte)
+ * @brief Map the AES register block into the address space of the process
+ * @return Pointer to the first register, NULL on failure
+ *
+ * @note The mapping is created once and reused. In the simulator build the register
+ * model takes the place of the /dev/mem mapping.
  ***************************************************************************************/
-static void AES_FPGA_xcrypt_buffer(int enc, const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+static volatile uint32_t *AES_FPGA_map(void) {
+	if (virtual_aes_base != NULL) {
+		return virtual_aes_base;
+	}
+
+#ifdef AES_FPGA_SIM
+	virtual_aes_base = AES_FPGA_SIM_map();
+#else
 	int  m_mfd;
+	void *base;
 
 	// Open Memory as a virtual file
     if ((m_mfd = open("/dev/mem", O_RDWR)) < 0) {
         printf("FAILED open /dev/mem\n");
-		return;
+		return NULL;
     }
 	
 	// Request a pointer for access to the AES region
-    virtual_aes_base = (void *)mmap(NULL, sysconf(_SC_PAGE_SIZE), PROT_READ|PROT_WRITE, MAP_SHARED, m_mfd, AES_BASE_ADDR);
+    base = mmap(NULL, sysconf(_SC_PAGE_SIZE), PROT_READ|PROT_WRITE, MAP_SHARED, m_mfd, AES_BASE_ADDR);
 	close(m_mfd);
 	
-    if (virtual_aes_base == MAP_FAILED) {
+    if (base == MAP_FAILED) {
         printf("FAILED virtual_aes_base\n");
-		return;
+		return NULL;
     }
+	virtual_aes_base = (volatile uint32_t *)base;
+#endif
 
-	// Registers are 32 bit, cast the pointer accordingly
-	uint32_t *aes_cbc_reg = (uint32_t *) (virtual_aes_base);
-
-	// APB is word oriented, cast function parameters
-	uint32_t *key_word = (uint32_t *)(key);
-	uint32_t *iv_word = (uint32_t *)(iv);
-	uint32_t *buf_word = (uint32_t *)(buf);
-	size_t length_word = length >> 2;
-
-	// Load the key
-	for (uint32_t i = 0; i < KEY_SIZE/DATA_BUS_SIZE; i++) {
-		aes_cbc_reg[AES_KEY_REG(i)] = key_word[i];
-		/* Kommentar an die Aufmerksamen: der Schlüssel wird in main.c byteweise
-		definiert, und zwar so, dass key[0] dem höchsten Byte entspricht, das an 
-		den AES-Block übergeben werden muss. */
+	return virtual_aes_base;
+}
+
+/****************************************************************************************
+ * @brief engine-based AES encryption
+ * @param enc[in]		Set 1 for encryption
+ * @param key[in]		Key, any alignment
+ * @param iv[in]		Initialization vector, any alignment
+ * @param buf[in/out]	Plain/Cipher text, any alignment
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ ***************************************************************************************/
+static void AES_FPGA_xcrypt_buffer(int enc, const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+	// Registers are 32 bit
+	volatile uint32_t *aes_cbc_reg = AES_FPGA_map();
+	if (aes_cbc_reg == NULL) {
+		return;
 	}
 
+	// Load the key, APB is word oriented (see aes_fpga_io.h for the byte order)
+	aes_fpga_write_words(aes_cbc_reg, AES_KEY_REG(0), key, KEY_SIZE/DATA_BUS_SIZE);
+
 	// set key length and select encryption or decryption operation in the configuration register
 	// register is write-only, can't read and modify!
 	// STUDENTS TASK
@@ -124,16 +117,14 @@ static void AES_FPGA_xcrypt_buffer(int enc, const uint8_t* key, const uint8_t* i
 
     config |= (AES_256_BIT_KEY << CONFIG_KEYLEN_BIT);
 
-    aes_cbc_reg[AES_CONFIG_REG] = config;
+    AES_REG_WRITE(aes_cbc_reg, AES_CONFIG_REG, config);
 
 	// initialize key expansion
 	// STUDENTS TASK
-	aes_cbc_reg[AES_CTRL_REG] = (1u << CTRL_INIT_BIT);
+	aes_fpga_kick(aes_cbc_reg, (1u << CTRL_INIT_BIT));
 
 	// Auf Ready-Bit im Status-Register warten
-    while ( (aes_cbc_reg[AES_STATUS_REG] & (1u << STATUS_READY_BIT)) == 0 ) {
-        // busy wait
-    }
+	aes_fpga_wait(aes_cbc_reg, STATUS_READY_BIT);
 
 	// Write the plaintext (or ciphertext) block to the block registers
 	if (length > 16) {
@@ -141,37 +132,39 @@ static void AES_FPGA_xcrypt_buffer(int enc, const uint8_t* key, const uint8_t* i
 		length = 16;
 	}
 	// STUDENTS TASK
-	for (uint32_t i = 0; i < (16u / DATA_BUS_SIZE); i++) {
-        aes_cbc_reg[AES_BLOCK_REG(i)] = buf_word[i];
-    }
+	aes_fpga_write_words(aes_cbc_reg, AES_BLOCK_REG(0), buf, 16u / DATA_BUS_SIZE);
 
 	// Write the IV to the IV registers
 	// STUDENTS TASK
-	for (uint32_t i = 0; i < (IV_SIZE / DATA_BUS_SIZE); i++) {
-        aes_cbc_reg[AES_IV_REG(i)] = iv_word[i];
-    }
+	aes_fpga_write_words(aes_cbc_reg, AES_IV_REG(0), iv, IV_SIZE / DATA_BUS_SIZE);
 
 	// Start block processing
 	// STUDENTS TASK
-	aes_cbc_reg[AES_CTRL_REG] = (1u << CTRL_NEXT_BIT);
+	aes_fpga_kick(aes_cbc_reg, (1u << CTRL_NEXT_BIT));
 
 	// wait for valid flag
 	// STUDENTS TASK
-	while ( (aes_cbc_reg[AES_STATUS_REG] & (1u << STATUS_VALID_BIT)) == 0 ) {
-        // busy wait
-    }
+	aes_fpga_wait(aes_cbc_reg, STATUS_VALID_BIT);
 
 	//Read out the ciphertext block from the result registers
 	// STUDENTS TASK
-	for (uint32_t i = 0; i < (16u / DATA_BUS_SIZE); i++) {
-        buf_word[i] = aes_cbc_reg[AES_RESULT_REG(i)];
-    }
+	aes_fpga_read_words(aes_cbc_reg, AES_RESULT_REG(0), buf, 16u / DATA_BUS_SIZE);
 }
 
 /****************************************************************************************
  * Global Functions
  ***************************************************************************************/
 
+/****************************************************************************************
+ * @brief Map the AES registers ahead of the first request
+ * @return 0 on success, -1 on failure
+ *
+ * @note Optional, the first encrypt/decrypt call maps the registers otherwise.
+ ***************************************************************************************/
+int AES_FPGA_start(void) {
+	return (AES_FPGA_map() != NULL) ? 0 : -1;
+}
+
 /****************************************************************************************
  * @brief FPGA-based AES encryption
  * @param key[in]		Key
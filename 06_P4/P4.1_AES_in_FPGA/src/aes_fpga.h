@@ -14,6 +14,7 @@
 /****************************************************************************************
  * Functions
  ***************************************************************************************/
+int AES_FPGA_start(void);
 void AES_FPGA_encrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
 void AES_FPGA_decrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
 
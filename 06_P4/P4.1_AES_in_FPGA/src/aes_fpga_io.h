@@ -0,0 +1,108 @@
+/****************************************************************************************
+ * @file
+ * @brief Word-wide register I/O between byte buffers and the FPGA AES block
+ *
+ * @note The AES core takes each 32-bit bus word least significant byte first, i.e.
+ * byte 4*i of a key, IV or block goes to bits 7..0 of word i. The helpers convert
+ * explicitly between that order and the CPU byte order, so callers may pass any
+ * byte buffer, aligned or not, and no layout trick in main.c is required.
+ *
+ * Only aligned 32-bit accesses are issued to the registers. The buffer side is a
+ * 4 byte memcpy per word, which compiles to a single load/store on the A53 whatever
+ * the alignment (unaligned accesses to normal memory are allowed), so no bounce
+ * buffer and no separate aligned path are needed.
+ *
+ * Barriers: the /dev/mem mapping is Device memory, so accesses to the block are
+ * already ordered among themselves. A barrier is only placed where the order of
+ * data and control must also hold if the region is mapped write-combining:
+ * AES_FPGA_IO_WMB() before the INIT/NEXT kick and AES_FPGA_IO_RMB() between
+ * seeing READY/VALID and reading the results.
+ ***************************************************************************************/
+
+#ifndef AES_FPGA_IO_H
+#define AES_FPGA_IO_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "aes_fpga_regs.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#if defined(__aarch64__) && !defined(AES_FPGA_SIM)
+#define AES_FPGA_IO_WMB()		__asm__ volatile ("dmb oshst" ::: "memory")
+#define AES_FPGA_IO_RMB()		__asm__ volatile ("dmb oshld" ::: "memory")
+#else
+#define AES_FPGA_IO_WMB()		__asm__ volatile ("" ::: "memory")
+#define AES_FPGA_IO_RMB()		__asm__ volatile ("" ::: "memory")
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define AES_FPGA_IO_TO_CORE(x)	__builtin_bswap32(x)
+#else
+#define AES_FPGA_IO_TO_CORE(x)	(x)
+#endif
+#define AES_FPGA_IO_FROM_CORE(x)	AES_FPGA_IO_TO_CORE(x)
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Write a byte buffer to consecutive registers
+ * @param regs[in]		Register base
+ * @param reg[in]		First register
+ * @param src[in]		Source bytes, any alignment
+ * @param n_words[in]	Number of 32-bit words
+ ***************************************************************************************/
+static inline void aes_fpga_write_words(volatile uint32_t *regs, uint32_t reg,
+                                        const uint8_t *src, size_t n_words) {
+	for (size_t i = 0; i < n_words; i++) {
+		uint32_t w;
+		memcpy(&w, src + 4*i, sizeof(w));
+		AES_REG_WRITE(regs, reg + i, AES_FPGA_IO_TO_CORE(w));
+	}
+}
+
+/****************************************************************************************
+ * @brief Read consecutive registers into a byte buffer
+ * @param regs[in]		Register base
+ * @param reg[in]		First register
+ * @param dst[out]		Destination bytes, any alignment
+ * @param n_words[in]	Number of 32-bit words
+ ***************************************************************************************/
+static inline void aes_fpga_read_words(volatile uint32_t *regs, uint32_t reg,
+                                       uint8_t *dst, size_t n_words) {
+	for (size_t i = 0; i < n_words; i++) {
+		uint32_t w = AES_FPGA_IO_FROM_CORE(AES_REG_READ(regs, reg + i));
+		memcpy(dst + 4*i, &w, sizeof(w));
+	}
+}
+
+/****************************************************************************************
+ * @brief Start an operation after all data registers have been written
+ * @param regs[in]		Register base
+ * @param ctrl[in]		Control word (INIT or NEXT)
+ ***************************************************************************************/
+static inline void aes_fpga_kick(volatile uint32_t *regs, uint32_t ctrl) {
+	AES_FPGA_IO_WMB();
+	AES_REG_WRITE(regs, AES_CTRL_REG, ctrl);
+}
+
+/****************************************************************************************
+ * @brief Busy wait for a status bit, results may be read afterwards
+ * @param regs[in]		Register base
+ * @param bit[in]		Status bit (STATUS_READY_BIT or STATUS_VALID_BIT)
+ ***************************************************************************************/
+static inline void aes_fpga_wait(volatile uint32_t *regs, uint32_t bit) {
+	while ((AES_REG_READ(regs, AES_STATUS_REG) & (1u << bit)) == 0) {
+		// busy wait
+	}
+	AES_FPGA_IO_RMB();
+}
+
+#endif  /* AES_FPGA_IO_H */
@@ -0,0 +1,60 @@
+/****************************************************************************************
+ * @file
+ * @brief Register map of the FPGA AES block
+ *
+ * @note Shared by the driver (aes_fpga.c) and the host-side register model
+ * (sim/aes_fpga_sim.c). Register offsets are word indices, not byte offsets.
+ ***************************************************************************************/
+
+#ifndef AES_FPGA_REGS_H
+#define AES_FPGA_REGS_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define AES_BASE_ADDR		(0x80020000)	//system.dts apb@80020000
+
+#define AES_CTRL_REG			(0x08)			//control register
+#define AES_STATUS_REG			(0x09)			//status register
+#define AES_CONFIG_REG			(0x0a)			//config register
+#define AES_KEY_REG(X)			(0x10+X)		//..0x17 key register for each 32bit data
+#define AES_BLOCK_REG(X)		(0x20+X)		//..0x23 block register
+#define AES_RESULT_REG(X)		(0x30+X)		//..0x33 result register
+#define AES_IV_REG(X)			(0x40+X)		//..0x43 initialization vector register
+
+#define AES_REG_COUNT			(0x44)			//number of words spanned by the register map
+
+#define CTRL_INIT_BIT			(0)
+#define CTRL_NEXT_BIT			(1)
+#define CONFIG_ENCDEC_BIT		(0)
+#define CONFIG_KEYLEN_BIT		(1)
+#define STATUS_READY_BIT		(0)
+#define STATUS_VALID_BIT		(1)
+
+#define AES_128_BIT_KEY			(0)
+#define AES_256_BIT_KEY			(1)
+#define AES_ENC					(1)
+#define AES_DEC					(0)
+
+/****************************************************************************************
+ * Register access
+ *
+ * On the target the registers are accessed through the /dev/mem mapping. With
+ * AES_FPGA_SIM defined (make sim) every access is routed to the register model
+ * instead, so the driver logic runs unchanged on a normal Linux machine.
+ ***************************************************************************************/
+#ifdef AES_FPGA_SIM
+#include "aes_fpga_sim.h"
+#define AES_REG_READ(regs, reg)			((void)(regs), AES_FPGA_SIM_read(reg))
+#define AES_REG_WRITE(regs, reg, val)	((void)(regs), AES_FPGA_SIM_write((reg), (val)))
+#else
+#define AES_REG_READ(regs, reg)			((regs)[reg])
+#define AES_REG_WRITE(regs, reg, val)	((regs)[reg] = (val))
+#endif
+
+#endif  /* AES_FPGA_REGS_H */
@@ -19,6 +19,7 @@
 #include <string.h>
 #include <time.h>
 #include "aes_fpga.h"
+#include "timing.h"
 
 
 /****************************************************************************************
@@ -91,15 +92,29 @@ int main(void) {
         return 1;
     }
 
-    struct timespec time_start, time_stop;
-    float time;
+    timing_run_t run;
+    int ok;
 
-    printf("\nTesting AES256\n");
+    printf("\nTesting AES256 (build: %s)\n", BUILD_TYPE);
 
-    clock_gettime(CLOCK_REALTIME, &time_start);
+    TIMING_init(&run);
+
+    TIMING_begin(&run, TIMING_START);
+    int success = AES_FPGA_start();
+    TIMING_end(&run, TIMING_START);
+    if (0 > success) {
+        printf("AES FPGA startup failed. exit program.\n");
+        return 2;
+    }
+
+    // the key is loaded and expanded with every call, there is no separate key setup
+    TIMING_begin(&run, TIMING_ENCRYPT);
     AES_FPGA_encrypt_buffer(key, iv, enc_a, text_length);
-    clock_gettime(CLOCK_REALTIME, &time_stop);
+    TIMING_end(&run, TIMING_ENCRYPT);
+
+    TIMING_begin(&run, TIMING_DECRYPT);
     AES_FPGA_decrypt_buffer(key, iv, dec_a, text_length);
+    TIMING_end(&run, TIMING_DECRYPT);
 
     printf("\n");
     printf("Input:  "); print_hex(dec_t, text_length);
@@ -107,7 +122,8 @@ int main(void) {
     printf("Soll:   "); print_hex(enc_t, text_length);
 
     printf("AES encrypt: ");
-    if (0 == memcmp((char*) enc_t, (char*) enc_a, text_length)) {
+    ok = (0 == memcmp((char*) enc_t, (char*) enc_a, text_length));
+    if (ok) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
@@ -123,14 +139,13 @@ int main(void) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
+        ok = 0;
     }
     
     // Zeitauswertung
-    time = (time_stop.tv_sec + time_stop.tv_nsec*1e-9)
-         - (time_start.tv_sec + time_start.tv_nsec*1e-9);
-
-    printf("\nMeasurement for setup, encryption, setup, decryption; Message size %li Bytes\n",text_length);
-    printf("Time: %.3f ms\n",time*1000);
+    printf("\nMeasurement per phase; Message size %zu Bytes\n", text_length);
+    TIMING_print(&run);
+    TIMING_print_json(&run, "fpga", text_length, ok);
 
     return 0;
 }
@@ -0,0 +1,131 @@
+/****************************************************************************************
+ * @file
+ * @brief Throughput of the asynchronous CSU queue at queue depths 1, 4 and 16
+ *
+ * @note Build with "make bench", run on the board:
+ *       ./csu_bench.elf [message size in bytes] [number of messages]
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <linux/if_alg.h>
+#include "aes_csu.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define DEFAULT_MESSAGE_SIZE	(4096)
+#define DEFAULT_MESSAGES		(4096)
+#ifndef BUILD_TYPE
+#define BUILD_TYPE		"unknown"		// build profile, set by the Makefile
+#endif
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Run one benchmark pass
+ * @param depth[in]		Queue depth
+ * @param size[in]		Message size
+ * @param messages[in]	Number of messages
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+static int run_depth(unsigned depth, size_t size, unsigned messages) {
+    // NIST test key and initialization vector
+    uint8_t key[] = { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+                      0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 };
+    uint8_t iv[]  = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+    aes_csu_queue_t queue;
+    aes_csu_completion_t done[AES_CSU_QUEUE_MAX_DEPTH];
+    uint8_t *buf[AES_CSU_QUEUE_MAX_DEPTH] = { 0 };
+    unsigned submitted = 0, completed = 0, errors = 0;
+    struct timespec time_start, time_stop;
+    int ret = -1;
+
+    if (AES_CSU_queue_open(&queue, key, depth) != 0) {
+        return -1;
+    }
+    for (unsigned i = 0; i < depth; i++) {
+        buf[i] = AES_CSU_buffer_alloc(size);
+        if (buf[i] == NULL) {
+            printf("out of memory\n");
+            goto out;
+        }
+        memset(buf[i], (int)i, size);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &time_start);
+
+    // fill the queue, then resubmit every buffer as soon as it completes
+    for (unsigned i = 0; i < depth && submitted < messages; i++, submitted++) {
+        if (AES_CSU_queue_submit(&queue, ALG_OP_ENCRYPT, iv, buf[i], size, buf[i]) != 0) {
+            goto out;
+        }
+    }
+    while (completed < messages) {
+        int n = AES_CSU_queue_poll(&queue, done, depth, 1);
+        if (n < 0) {
+            goto out;
+        }
+        for (int i = 0; i < n; i++, completed++) {
+            if (done[i].result != (long)size) {
+                errors++;
+            }
+            if (submitted < messages) {
+                if (AES_CSU_queue_submit(&queue, ALG_OP_ENCRYPT, iv, done[i].buf, size, done[i].buf) != 0) {
+                    goto out;
+                }
+                submitted++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &time_stop);
+
+    double time = (time_stop.tv_sec - time_start.tv_sec)
+                + (time_stop.tv_nsec - time_start.tv_nsec) * 1e-9;
+    printf("depth %2u: %u x %zu Bytes in %.3f ms, %.2f MB/s, %u errors\n",
+           depth, messages, size, time * 1000, (double)messages * size / time / 1e6, errors);
+    ret = errors ? -1 : 0;
+
+out:
+    AES_CSU_queue_close(&queue);
+    for (unsigned i = 0; i < depth; i++) {
+        free(buf[i]);
+    }
+    return ret;
+}
+
+/****************************************************************************************
+ * @brief main
+ ***************************************************************************************/
+int main(int argc, char *argv[]) {
+    const unsigned depths[] = { 1, 4, 16 };
+    size_t size = DEFAULT_MESSAGE_SIZE;
+    unsigned messages = DEFAULT_MESSAGES;
+    int ret = 0;
+
+    if (argc > 1) size = strtoul(argv[1], NULL, 0);
+    if (argc > 2) messages = strtoul(argv[2], NULL, 0);
+
+    if (size == 0 || size % 16 != 0) {
+        printf("ERROR: String length must be evenly divisible by 16byte (currently %zu)\n", size);
+        return 1;
+    }
+
+    printf("\nCSU queue throughput, AES256-CBC encrypt, build %s\n", BUILD_TYPE);
+    for (unsigned i = 0; i < sizeof(depths)/sizeof(depths[0]); i++) {
+        if (run_depth(depths[i], size, messages) != 0) {
+            ret = 1;
+        }
+    }
+    return ret;
+}
@@ -12,18 +12,38 @@
 /****************************************************************************************
  * Includes
  ***************************************************************************************/
+#define _GNU_SOURCE		// vmsplice, splice, F_SETPIPE_SZ
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/aio_abi.h>
 #include <sys/syscall.h>
 #include <linux/if_alg.h>
 #include "aes_csu.h"
 
 /* SETTINGS */
 #define AES_KEY_LENGTH 32
+#define AES_BLOCK_LENGTH 16
+
+/* zero-copy path: messages of at least AES_CSU_SPLICE_THRESHOLD bytes in page aligned
+ * buffers are spliced into the op socket in chunks of AES_CSU_SPLICE_CHUNK bytes,
+ * which is the amount of data the AF_ALG socket accepts per request (16 pages) */
+#define AES_CSU_SPLICE_THRESHOLD	(16 * 1024)
+#define AES_CSU_SPLICE_CHUNK		(16 * 4096)
+
+
+/****************************************************************************************
+ * Variables
+ ***************************************************************************************/
+/* session used by the key/iv based API, rekeyed only when the key changes */
+static aes_csu_session_t default_session = { .tfm_fd = -1, .op_fd = -1, .pipe_fd = { -1, -1 } };
+static uint8_t default_key[AES_KEY_LENGTH];
 
 
 /****************************************************************************************
@@ -31,17 +51,31 @@
  ***************************************************************************************/
 
 /****************************************************************************************
- * @brief CSU-based AES encryption
+ * @brief Accept an operation socket on the keyed transform socket
+ * @param tfm_fd[in]	Transform socket, bound and keyed
+ * @return Operation socket, -1 on failure
+ ***************************************************************************************/
+static int AES_CSU_accept(int tfm_fd) {
+	/* get a file descriptor for data transfer */
+	int fd = accept(tfm_fd, NULL, 0);
+	if (fd == -1) {
+		printf("accept failed: %s\n", strerror(errno));
+	}
+	return fd;
+}
+
+/****************************************************************************************
+ * @brief Send one message with its own operation and IV to an operation socket
+ * @param fd[in]		Operation socket
  * @param enc_dir[in]	encryption or decryption (ALG_OP_ENCRYPT, ALG_OP_DECRYPT)
- * @param key[in]		Key
  * @param iv[in]		Initialization vector
- * @param buf[in/out]	Plain/Cipher text
+ * @param buf[in]		Plain/Cipher text
  * @param length[in]	Length of text (must be divisible by 16byte)
+ * @param flags[in]		sendmsg flags (MSG_MORE if more data follows)
+ * @return 0 on success, -1 on failure
  ***************************************************************************************/
-static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
+static int AES_CSU_send(int fd, int enc_dir, const uint8_t* iv, const uint8_t* buf, size_t length, int flags) {
 	int ret;
-	int sd;
-	int fd;
 	/* msghdr structure to send data with settings to kernel */
 	struct msghdr msg = {};
 
@@ -53,11 +87,174 @@ static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t
 	/* pointer for elements from cbuf */
 	struct cmsghdr *cmsg;
 
-
 	/* prepare buffer to send data to kernel */
 	struct af_alg_iv *ivp;
-	struct iovec iov = {buf, length};
+	struct iovec iov = {(void *)buf, length};
+
+	/* settings for encryption:
+	* Header for ancillary data objects in msg_control buffer.
+	* Used for additional information with/about a datagram
+	* not expressible by flags.  The format is a sequence
+	* of message elements headed by cmsghdr structures.
+	*/
+	cmsg = CMSG_FIRSTHDR(&msg);				// get pointer to first cmsg_header (data object in msg_control buffer 'msg')
+	cmsg->cmsg_level = SOL_ALG;
+	cmsg->cmsg_type = ALG_SET_OP;
+	cmsg->cmsg_len = CMSG_LEN(4);
+	*(__u32 *)CMSG_DATA(cmsg) = enc_dir;	// copy message content into data structure
+	cmsg = CMSG_NXTHDR(&msg, cmsg);			// get pointer to next cmsg_header
+	cmsg->cmsg_level = SOL_ALG;
+	cmsg->cmsg_type = ALG_SET_IV;
+	cmsg->cmsg_len = CMSG_LEN(20);
+	ivp = (void *)CMSG_DATA(cmsg);			// copy iv content into data structure
+	ivp->ivlen = 16;
+
+	/* set iv for cbc algorithm */
+	memcpy(ivp->iv, iv, 16);
+	/* set pointer to plaintext/ciphertext buffer */
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	/* send data to encrypt/decrypt */
+	// STUDENTS TASK: send message buffer through socket
+	ret = sendmsg(fd, &msg, flags);
+
+	if (ret == -1) {
+		printf("sendmsg failed: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Read a processed message back from an operation socket
+ * @param fd[in]		Operation socket
+ * @param buf[out]		Plain/Cipher text
+ * @param length[in]	Length of text
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+static int AES_CSU_recv(int fd, uint8_t* buf, size_t length) {
+	/* get encrypted/decrypted data */
+	while (length > 0) {
+		ssize_t ret = read(fd, buf, length);
+		if (ret <= 0) {
+			printf("read failed: %s\n", ret == 0 ? "no data" : strerror(errno));
+			return -1;
+		}
+		buf += ret;
+		length -= ret;
+	}
+	return 0;
+}
+
 
+/****************************************************************************************
+ * @brief Create the pipe used to splice user pages into the op socket
+ * @param session[in]	Session
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+static int AES_CSU_pipe(aes_csu_session_t *session) {
+	if (session->pipe_fd[0] >= 0) {
+		return 0;
+	}
+	if (pipe(session->pipe_fd) == -1) {
+		printf("pipe failed: %s\n", strerror(errno));
+		return -1;
+	}
+	/* a full chunk must fit into the pipe, failure leaves the default size (16 pages) */
+	fcntl(session->pipe_fd[1], F_SETPIPE_SZ, AES_CSU_SPLICE_CHUNK);
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Map a user buffer into the pipe and splice it into the op socket
+ * @param session[in]	Session
+ * @param buf[in]		Chunk of plain/cipher text
+ * @param length[in]	Length of the chunk (at most AES_CSU_SPLICE_CHUNK)
+ * @return 0 on success, -1 on failure
+ *
+ * @note Every splice carries SPLICE_F_MORE, also a partial one of the last batch, so
+ * the request stays open until the caller ends it with AES_CSU_end().
+ ***************************************************************************************/
+static int AES_CSU_splice_chunk(aes_csu_session_t *session, const uint8_t* buf, size_t length) {
+	struct iovec iov = {(void *)buf, length};
+
+	while (iov.iov_len > 0) {
+		/* user pages are referenced by the pipe, not copied */
+		ssize_t mapped = vmsplice(session->pipe_fd[1], &iov, 1, 0);
+		if (mapped <= 0) {
+			printf("vmsplice failed: %s\n", strerror(errno));
+			return -1;
+		}
+		iov.iov_base = (uint8_t *)iov.iov_base + mapped;
+		iov.iov_len -= mapped;
+
+		while (mapped > 0) {
+			ssize_t moved = splice(session->pipe_fd[0], NULL, session->op_fd, NULL, mapped,
+			                       SPLICE_F_MORE);
+			if (moved <= 0) {
+				printf("splice failed: %s\n", strerror(errno));
+				return -1;
+			}
+			mapped -= moved;
+		}
+	}
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Complete a request that was sent with MSG_MORE/SPLICE_F_MORE
+ * @param fd[in]		Operation socket
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+static int AES_CSU_end(int fd) {
+	/* zero-length send without MSG_MORE, the data is already queued */
+	if (send(fd, NULL, 0, 0) == -1) {
+		printf("send failed: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+
+/****************************************************************************************
+ * @brief Kernel AIO system calls (no libaio in the sysroot)
+ ***************************************************************************************/
+static int sys_io_setup(unsigned nr, aio_context_t *ctx) {
+	return syscall(__NR_io_setup, nr, ctx);
+}
+
+static int sys_io_destroy(aio_context_t ctx) {
+	return syscall(__NR_io_destroy, ctx);
+}
+
+static int sys_io_submit(aio_context_t ctx, long nr, struct iocb **cbs) {
+	return syscall(__NR_io_submit, ctx, nr, cbs);
+}
+
+static int sys_io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event *events) {
+	return syscall(__NR_io_getevents, ctx, min_nr, nr, events, NULL);
+}
+
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Open a CSU session: bind and key the transform once, keep the op socket open
+ * @param session[out]	Session
+ * @param key[in]		Key (AES_KEY_LENGTH bytes)
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+int AES_CSU_session_open(aes_csu_session_t *session, const uint8_t* key) {
+	int ret;
+	int sd;
+
+	session->tfm_fd = -1;
+	session->op_fd = -1;
+	session->pipe_fd[0] = -1;
+	session->pipe_fd[1] = -1;
 
 	/*  create socket of type AF_ALG */
     // STUDENTS TASK: open a socket
@@ -65,7 +262,7 @@ static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t
 
 	if (sd == -1) {
 		printf("socket failed: %s\n", strerror(errno));
-		return;
+		return -1;
 	}
 
 	/* create structure and select encryption algorithm */
@@ -83,7 +280,7 @@ static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t
 	if (ret == -1) {
 		printf("bind failed: %s\n", strerror(errno));
 		close(sd);
-		return;
+		return -1;
 	}
 
 	/* set key for aes encryption */
@@ -93,69 +290,341 @@ static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t
 	if (ret == -1) {
 		printf("setsockopt failed: %s\n", strerror(errno));
 		close(sd);
-		return;
+		return -1;
 	}
 
-	/* get a file descriptor for data transfer */
-	fd = accept(sd, NULL, 0);
-	if (fd == -1) {
-		printf("accept failed: %s\n", strerror(errno));
+	session->op_fd = AES_CSU_accept(sd);
+	if (session->op_fd == -1) {
 		close(sd);
-		return;
+		return -1;
 	}
-	close(sd);
+	session->tfm_fd = sd;
 
+	return 0;
+}
 
-	/* settings for encryption:
-	* Header for ancillary data objects in msg_control buffer.
-	* Used for additional information with/about a datagram
-	* not expressible by flags.  The format is a sequence
-	* of message elements headed by cmsghdr structures.
-	*/
-	cmsg = CMSG_FIRSTHDR(&msg);				// get pointer to first cmsg_header (data object in msg_control buffer 'msg')
-	cmsg->cmsg_level = SOL_ALG;
-	cmsg->cmsg_type = ALG_SET_OP;
-	cmsg->cmsg_len = CMSG_LEN(4);
-	*(__u32 *)CMSG_DATA(cmsg) = enc_dir;	// copy message content into data structure
-	cmsg = CMSG_NXTHDR(&msg, cmsg);			// get pointer to next cmsg_header
-	cmsg->cmsg_level = SOL_ALG;
-	cmsg->cmsg_type = ALG_SET_IV;
-	cmsg->cmsg_len = CMSG_LEN(20);
-	ivp = (void *)CMSG_DATA(cmsg);			// copy iv content into data structure
-	ivp->ivlen = 16;
+/****************************************************************************************
+ * @brief Close a CSU session
+ * @param session[in]	Session
+ ***************************************************************************************/
+void AES_CSU_session_close(aes_csu_session_t *session) {
+	if (session->op_fd >= 0) {
+		close(session->op_fd);
+	}
+	if (session->tfm_fd >= 0) {
+		close(session->tfm_fd);
+	}
+	if (session->pipe_fd[0] >= 0) {
+		close(session->pipe_fd[0]);
+		close(session->pipe_fd[1]);
+	}
+	session->op_fd = -1;
+	session->tfm_fd = -1;
+	session->pipe_fd[0] = -1;
+	session->pipe_fd[1] = -1;
+}
 
-	/* set iv for cbc algorithm */
-	memcpy(ivp->iv, iv, 16);
-	iov.iov_len = length;
-	/* set pointer to plaintext/ciphertext buffer */
-	msg.msg_iov = &iov;
-	msg.msg_iovlen = 1;
+/****************************************************************************************
+ * @brief CSU-based AES encryption/decryption of one message on an open session
+ * @param session[in]	Session
+ * @param enc_dir[in]	encryption or decryption (ALG_OP_ENCRYPT, ALG_OP_DECRYPT)
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Plain/Cipher text
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ * @return 0 on success, -1 on failure
+ *
+ * @note Costs two syscalls (sendmsg and read), op and IV travel in the cmsg.
+ * Large messages to encrypt in page aligned buffers take the zero-copy splice path.
+ ***************************************************************************************/
+int AES_CSU_session_xcrypt(aes_csu_session_t *session, int enc_dir, const uint8_t* iv, uint8_t* buf, size_t length) {
+	if (enc_dir == ALG_OP_ENCRYPT && length >= AES_CSU_SPLICE_THRESHOLD
+	    && ((uintptr_t)buf % sysconf(_SC_PAGE_SIZE)) == 0) {
+		return AES_CSU_session_xcrypt_splice(session, enc_dir, iv, buf, buf, length);
+	}
 
-	/* send data to encrypt/decrypt */
-	// STUDENTS TASK: send message buffer through socket
-	ret = sendmsg(fd, &msg, 0);
+	if (AES_CSU_send(session->op_fd, enc_dir, iv, buf, length, 0) != 0) {
+		return -1;
+	}
+	return AES_CSU_recv(session->op_fd, buf, length);
+}
 
-	if (ret == -1) {
-		printf("sendmsg failed: %s\n", strerror(errno));
-		close(fd);
-		return;
+/****************************************************************************************
+ * @brief Zero-copy CSU-based AES encryption/decryption of a large message
+ * @param session[in]	Session
+ * @param enc_dir[in]	encryption or decryption (ALG_OP_ENCRYPT, ALG_OP_DECRYPT)
+ * @param iv[in]		Initialization vector
+ * @param in[in]		Plain/Cipher text, page aligned for zero-copy
+ * @param out[out]		Cipher/Plain text, may be equal to in only for encryption
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ * @return 0 on success, -1 on failure
+ *
+ * @note The input pages are handed to the kernel with vmsplice/splice instead of being
+ * copied by sendmsg, the output pages are written directly by read. Messages larger
+ * than AES_CSU_SPLICE_CHUNK are streamed as a sequence of requests; the IV of each
+ * request is the last ciphertext block of the previous one, so the result is
+ * identical to a single CBC pass.
+ * In-place decryption is not allowed: the kernel sees source and destination as
+ * different pages and CBC decryption would chain on already overwritten blocks.
+ * Overlapping in and out ranges are rejected for decryption.
+ ***************************************************************************************/
+int AES_CSU_session_xcrypt_splice(aes_csu_session_t *session, int enc_dir, const uint8_t* iv,
+                                  const uint8_t* in, uint8_t* out, size_t length) {
+	uint8_t chain_iv[AES_BLOCK_LENGTH];
+
+	if (enc_dir == ALG_OP_DECRYPT && in < out + length && out < in + length) {
+		printf("splice: in-place decryption is not supported\n");
+		return -1;
 	}
+	if (AES_CSU_pipe(session) != 0) {
+		return -1;
+	}
+	memcpy(chain_iv, iv, AES_BLOCK_LENGTH);
 
-	/* get encrypted/decrypted data */
-	ret = read(fd, buf, length);
-	if (ret == -1) {
-		printf("read failed: %s\n", strerror(errno));
-		close(fd);
-		return;
+	while (length > 0) {
+		size_t chunk = (length > AES_CSU_SPLICE_CHUNK) ? AES_CSU_SPLICE_CHUNK : length;
+
+		/* op and IV only, the data follows through the pipe */
+		if (AES_CSU_send(session->op_fd, enc_dir, chain_iv, NULL, 0, MSG_MORE) != 0) {
+			return -1;
+		}
+		if (AES_CSU_splice_chunk(session, in, chunk) != 0) {
+			return -1;
+		}
+		if (AES_CSU_end(session->op_fd) != 0) {
+			return -1;
+		}
+		if (AES_CSU_recv(session->op_fd, out, chunk) != 0) {
+			return -1;
+		}
+
+		/* CBC chains on the last ciphertext block of the chunk */
+		if (enc_dir == ALG_OP_ENCRYPT) {
+			memcpy(chain_iv, out + chunk - AES_BLOCK_LENGTH, AES_BLOCK_LENGTH);
+		} else {
+			memcpy(chain_iv, in + chunk - AES_BLOCK_LENGTH, AES_BLOCK_LENGTH);
+		}
+
+		in += chunk;
+		out += chunk;
+		length -= chunk;
 	}
+	return 0;
+}
 
-	close(fd);
+/****************************************************************************************
+ * @brief Allocate a page aligned message buffer, eligible for the zero-copy path
+ * @param length[in]	Length of the buffer
+ * @return Buffer (release with free), NULL on failure
+ ***************************************************************************************/
+void *AES_CSU_buffer_alloc(size_t length) {
+	void *buf;
+	if (posix_memalign(&buf, sysconf(_SC_PAGE_SIZE), length) != 0) {
+		return NULL;
+	}
+	return buf;
 }
 
+/****************************************************************************************
+ * @brief CSU-based AES encryption on an open session
+ * @param session[in]	Session
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Plain text
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+int AES_CSU_session_encrypt(aes_csu_session_t *session, const uint8_t* iv, uint8_t* buf, size_t length) {
+	return AES_CSU_session_xcrypt(session, ALG_OP_ENCRYPT, iv, buf, length);
+}
 
 /****************************************************************************************
- * Global Functions
+ * @brief CSU-based AES decryption on an open session
+ * @param session[in]	Session
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Cipher text
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ * @return 0 on success, -1 on failure
+ ***************************************************************************************/
+int AES_CSU_session_decrypt(aes_csu_session_t *session, const uint8_t* iv, uint8_t* buf, size_t length) {
+	return AES_CSU_session_xcrypt(session, ALG_OP_DECRYPT, iv, buf, length);
+}
+
+/****************************************************************************************
+ * @brief Open an asynchronous CSU queue
+ * @param queue[out]	Queue
+ * @param key[in]		Key (AES_KEY_LENGTH bytes)
+ * @param depth[in]		Maximum number of requests in flight (1..AES_CSU_QUEUE_MAX_DEPTH)
+ * @return 0 on success, -1 on failure
+ *
+ * @note Every slot gets its own op socket on the shared keyed transform. Reads are
+ * submitted with kernel AIO, which AF_ALG processes asynchronously, so the crypto
+ * engine works on queued requests while user space prepares the next buffers.
  ***************************************************************************************/
+int AES_CSU_queue_open(aes_csu_queue_t *queue, const uint8_t* key, unsigned depth) {
+	memset(queue, 0, sizeof(*queue));
+	for (unsigned i = 0; i < AES_CSU_QUEUE_MAX_DEPTH; i++) {
+		queue->slot[i].op_fd = -1;
+	}
+	if (depth == 0 || depth > AES_CSU_QUEUE_MAX_DEPTH) {
+		printf("queue depth %u not supported\n", depth);
+		return -1;
+	}
+	queue->depth = depth;
+
+	if (AES_CSU_session_open(&queue->session, key) != 0) {
+		return -1;
+	}
+	for (unsigned i = 0; i < depth; i++) {
+		queue->slot[i].op_fd = AES_CSU_accept(queue->session.tfm_fd);
+		if (queue->slot[i].op_fd == -1) {
+			AES_CSU_queue_close(queue);
+			return -1;
+		}
+	}
+	if (sys_io_setup(depth, &queue->aio) == -1) {
+		printf("io_setup failed: %s\n", strerror(errno));
+		queue->aio = 0;
+		AES_CSU_queue_close(queue);
+		return -1;
+	}
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Close an asynchronous CSU queue, requests still in flight are dropped
+ * @param queue[in]		Queue
+ ***************************************************************************************/
+void AES_CSU_queue_close(aes_csu_queue_t *queue) {
+	if (queue->aio != 0) {
+		sys_io_destroy(queue->aio);		// waits for requests in flight
+		queue->aio = 0;
+	}
+	for (unsigned i = 0; i < AES_CSU_QUEUE_MAX_DEPTH; i++) {
+		if (queue->slot[i].op_fd >= 0) {
+			close(queue->slot[i].op_fd);
+			queue->slot[i].op_fd = -1;
+		}
+		queue->slot[i].busy = 0;
+	}
+	queue->in_flight = 0;
+	AES_CSU_session_close(&queue->session);
+}
+
+/****************************************************************************************
+ * @brief Submit a request without waiting for its result
+ * @param queue[in]		Queue
+ * @param enc_dir[in]	encryption or decryption (ALG_OP_ENCRYPT, ALG_OP_DECRYPT)
+ * @param iv[in]		Initialization vector
+ * @param buf[in/out]	Plain/Cipher text, must stay valid until completion
+ * @param length[in]	Length of text (must be divisible by 16byte)
+ * @param tag[in]		Caller data, returned on completion
+ * @return 0 on success, -1 if the queue is full or on failure
+ *
+ * @note buf is not touched if -1 is returned.
+ ***************************************************************************************/
+int AES_CSU_queue_submit(aes_csu_queue_t *queue, int enc_dir, const uint8_t* iv, uint8_t* buf, size_t length, void *tag) {
+	aes_csu_slot_t *slot = NULL;
+	struct iocb *cbs[1];
+
+	for (unsigned i = 0; i < queue->depth; i++) {
+		if (!queue->slot[i].busy && queue->slot[i].op_fd >= 0) {
+			slot = &queue->slot[i];
+			break;
+		}
+	}
+	if (slot == NULL) {
+		return -1;
+	}
+
+	if (AES_CSU_send(slot->op_fd, enc_dir, iv, buf, length, 0) != 0) {
+		return -1;
+	}
+
+	memset(&slot->cb, 0, sizeof(slot->cb));
+	slot->cb.aio_data = (uint64_t)(uintptr_t)slot;
+	slot->cb.aio_lio_opcode = IOCB_CMD_PREAD;
+	slot->cb.aio_fildes = slot->op_fd;
+	slot->cb.aio_buf = (uint64_t)(uintptr_t)buf;
+	slot->cb.aio_nbytes = length;
+	cbs[0] = &slot->cb;
+
+	if (sys_io_submit(queue->aio, 1, cbs) != 1) {
+		printf("io_submit failed: %s\n", strerror(errno));
+		/* drop the request already sent with its socket, a fresh one takes the slot;
+		 * reading it back would overwrite buf although the call fails */
+		close(slot->op_fd);
+		slot->op_fd = AES_CSU_accept(queue->session.tfm_fd);
+		return -1;
+	}
+
+	slot->busy = 1;
+	slot->tag = tag;
+	slot->buf = buf;
+	slot->length = length;
+	queue->in_flight++;
+	return 0;
+}
+
+/****************************************************************************************
+ * @brief Collect completed requests
+ * @param queue[in]		Queue
+ * @param done[out]		Completed requests
+ * @param max[in]		Size of done
+ * @param min[in]		Minimum number of completions to wait for (0: do not block)
+ * @return Number of completions in done, -1 on failure
+ ***************************************************************************************/
+int AES_CSU_queue_poll(aes_csu_queue_t *queue, aes_csu_completion_t *done, unsigned max, unsigned min) {
+	struct io_event events[AES_CSU_QUEUE_MAX_DEPTH];
+	int n;
+
+	if (max > AES_CSU_QUEUE_MAX_DEPTH) {
+		max = AES_CSU_QUEUE_MAX_DEPTH;
+	}
+	if (min > queue->in_flight) {
+		min = queue->in_flight;
+	}
+	if (min > max) {
+		min = max;
+	}
+	if (queue->in_flight == 0) {
+		return 0;
+	}
+
+	do {
+		n = sys_io_getevents(queue->aio, min, max, events);
+	} while (n == -1 && errno == EINTR);
+	if (n == -1) {
+		printf("io_getevents failed: %s\n", strerror(errno));
+		return -1;
+	}
+
+	for (int i = 0; i < n; i++) {
+		aes_csu_slot_t *slot = (aes_csu_slot_t *)(uintptr_t)events[i].data;
+		done[i].tag = slot->tag;
+		done[i].buf = slot->buf;
+		done[i].result = (long)events[i].res;
+		slot->busy = 0;
+		queue->in_flight--;
+	}
+	return n;
+}
+
+/****************************************************************************************
+ * @brief Get the session for the key/iv based API, rekey only if the key changed
+ * @param key[in]		Key
+ * @return Session, NULL on failure
+ ***************************************************************************************/
+static aes_csu_session_t *AES_CSU_default_session(const uint8_t* key) {
+	if (default_session.op_fd >= 0 && 0 == memcmp(default_key, key, AES_KEY_LENGTH)) {
+		return &default_session;
+	}
+
+	AES_CSU_session_close(&default_session);
+	if (AES_CSU_session_open(&default_session, key) != 0) {
+		return NULL;
+	}
+	memcpy(default_key, key, AES_KEY_LENGTH);
+	return &default_session;
+}
 
 /****************************************************************************************
  * @brief CSU-based AES encryption
@@ -165,7 +634,10 @@ static void AES_CSU_xcrypt_buffer(int enc_dir, const uint8_t* key, const uint8_t
  * @param length[in]	Length of text (must be divisible by 16byte)
  ***************************************************************************************/
 void AES_CSU_encrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
-	AES_CSU_xcrypt_buffer(ALG_OP_ENCRYPT, key, iv, buf, length);
+	aes_csu_session_t *session = AES_CSU_default_session(key);
+	if (session != NULL) {
+		AES_CSU_session_encrypt(session, iv, buf, length);
+	}
 }
 
 /****************************************************************************************
@@ -176,5 +648,8 @@ void AES_CSU_encrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf,
  * @param length[in]	Length of text (must be divisible by 16byte)
  ***************************************************************************************/
 void AES_CSU_decrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length) {
-	AES_CSU_xcrypt_buffer(ALG_OP_DECRYPT, key, iv, buf, length);
+	aes_csu_session_t *session = AES_CSU_default_session(key);
+	if (session != NULL) {
+		AES_CSU_session_decrypt(session, iv, buf, length);
+	}
 }
@@ -10,10 +10,67 @@
  * Includes
  ***************************************************************************************/
 #include <stdint.h>
+#include <stddef.h>
+#include <linux/aio_abi.h>
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define AES_CSU_QUEUE_MAX_DEPTH	(16)
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+/* Persistent AF_ALG session: transform socket bound and keyed once, op socket kept open */
+typedef struct {
+	int tfm_fd;		// transform socket (bind, ALG_SET_KEY)
+	int op_fd;		// accepted operation socket (sendmsg, read)
+	int pipe_fd[2];	// pipe for the zero-copy path, created on first use
+} aes_csu_session_t;
+
+/* One request of the asynchronous queue */
+typedef struct {
+	int op_fd;			// own operation socket, accepted on the shared transform
+	int busy;			// request in flight
+	void *tag;			// caller data, returned on completion
+	uint8_t *buf;		// in/out buffer of the request
+	size_t length;
+	struct iocb cb;		// AIO read that completes the request
+} aes_csu_slot_t;
+
+/* Asynchronous CSU queue: up to depth requests in flight, one completion queue */
+typedef struct {
+	aes_csu_session_t session;	// keyed transform, op_fd unused
+	aio_context_t aio;			// kernel AIO context, the completion queue
+	unsigned depth;
+	unsigned in_flight;
+	aes_csu_slot_t slot[AES_CSU_QUEUE_MAX_DEPTH];
+} aes_csu_queue_t;
+
+/* Completed request */
+typedef struct {
+	void *tag;			// tag given to AES_CSU_queue_submit
+	uint8_t *buf;		// processed buffer
+	long result;		// bytes processed, negative errno on failure
+} aes_csu_completion_t;
 
 /****************************************************************************************
  * Functions
  ***************************************************************************************/
+int AES_CSU_session_open(aes_csu_session_t *session, const uint8_t* key);
+void AES_CSU_session_close(aes_csu_session_t *session);
+int AES_CSU_session_xcrypt(aes_csu_session_t *session, int enc_dir, const uint8_t* iv, uint8_t* buf, size_t length);
+int AES_CSU_session_xcrypt_splice(aes_csu_session_t *session, int enc_dir, const uint8_t* iv,
+                                  const uint8_t* in, uint8_t* out, size_t length);
+void *AES_CSU_buffer_alloc(size_t length);
+int AES_CSU_session_encrypt(aes_csu_session_t *session, const uint8_t* iv, uint8_t* buf, size_t length);
+int AES_CSU_session_decrypt(aes_csu_session_t *session, const uint8_t* iv, uint8_t* buf, size_t length);
+
+int AES_CSU_queue_open(aes_csu_queue_t *queue, const uint8_t* key, unsigned depth);
+void AES_CSU_queue_close(aes_csu_queue_t *queue);
+int AES_CSU_queue_submit(aes_csu_queue_t *queue, int enc_dir, const uint8_t* iv, uint8_t* buf, size_t length, void *tag);
+int AES_CSU_queue_poll(aes_csu_queue_t *queue, aes_csu_completion_t *done, unsigned max, unsigned min);
+
 void AES_CSU_encrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
 void AES_CSU_decrypt_buffer(const uint8_t* key, const uint8_t* iv, uint8_t* buf, size_t length);
 
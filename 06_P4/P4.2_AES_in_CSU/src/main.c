@@ -19,6 +19,7 @@
 #include <string.h>
 #include <time.h>
 #include "aes_csu.h"
+#include "timing.h"
 
 
 /****************************************************************************************
@@ -91,15 +92,34 @@ int main(void) {
         return 1;
     }
 
-    struct timespec time_start, time_stop;
-    float time;
+    timing_run_t run;
+    aes_csu_session_t session;
+    int ok;
 
-    printf("\nTesting AES256\n");
+    printf("\nTesting AES256 (build: %s)\n", BUILD_TYPE);
 
-    clock_gettime(CLOCK_REALTIME, &time_start);
-    AES_CSU_encrypt_buffer(key, iv, enc_a, text_length);
-    clock_gettime(CLOCK_REALTIME, &time_stop);
-    AES_CSU_decrypt_buffer(key, iv, dec_a, text_length);
+    TIMING_init(&run);
+
+    // opening the session binds the transform and loads the key
+    TIMING_begin(&run, TIMING_KEY_SETUP);
+    int success = AES_CSU_session_open(&session, key);
+    TIMING_end(&run, TIMING_KEY_SETUP);
+    if (0 > success) {
+        printf("AES CSU session failed. exit program.\n");
+        return 2;
+    }
+
+    TIMING_begin(&run, TIMING_ENCRYPT);
+    AES_CSU_session_encrypt(&session, iv, enc_a, text_length);
+    TIMING_end(&run, TIMING_ENCRYPT);
+
+    TIMING_begin(&run, TIMING_DECRYPT);
+    AES_CSU_session_decrypt(&session, iv, dec_a, text_length);
+    TIMING_end(&run, TIMING_DECRYPT);
+
+    TIMING_begin(&run, TIMING_TEARDOWN);
+    AES_CSU_session_close(&session);
+    TIMING_end(&run, TIMING_TEARDOWN);
 
     printf("\n");
     printf("Input:  "); print_hex(dec_t, text_length);
@@ -107,7 +127,8 @@ int main(void) {
     printf("Soll:   "); print_hex(enc_t, text_length);
 
     printf("AES encrypt: ");
-    if (0 == memcmp((char*) enc_t, (char*) enc_a, text_length)) {
+    ok = (0 == memcmp((char*) enc_t, (char*) enc_a, text_length));
+    if (ok) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
@@ -123,14 +144,13 @@ int main(void) {
         printf("SUCCESS!\n");
     } else {
         printf("FAILURE!\n");
+        ok = 0;
     }
     
     // Zeitauswertung
-    time = (time_stop.tv_sec + time_stop.tv_nsec*1e-9)
-         - (time_start.tv_sec + time_start.tv_nsec*1e-9);
-
-    printf("\nMeasurement for setup, encryption, setup, decryption; Message size %li Bytes\n",text_length);
-    printf("Time: %.3f ms\n",time*1000);
+    printf("\nMeasurement per phase; Message size %zu Bytes\n", text_length);
+    TIMING_print(&run);
+    TIMING_print_json(&run, "csu", text_length, ok);
 
     return 0;
 }
@@ -0,0 +1,153 @@
+/****************************************************************************************
+ * @file
+ * @brief Per-phase timing of one AES run with machine readable output
+ *
+ * @note Every span is taken from two clocks: CLOCK_MONOTONIC_RAW in nanoseconds (not
+ * slewed by NTP) and the virtual count of the ARM generic timer, which costs no system
+ * call. Both are kept as uint64_t, a float loses the nanoseconds after a few seconds.
+ *
+ * A phase may be begun and ended several times, its spans add up. TIMING_print_json()
+ * writes one line per run so the output of all engines can be collected with grep:
+ *   {"engine":"apu","build":"release","bytes":240,"ok":true,"tick_hz":100000000,
+ *    "encrypt_ns":51230,"encrypt_ticks":5123,...,"total_ns":60110,"total_ticks":6011}
+ * Phases that were never recorded are left out.
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "timing.h"
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#define NS_PER_S		(1000000000ull)
+
+static const char *const phase_names[TIMING_PHASES] = {
+	"start", "key_setup", "encrypt", "decrypt", "teardown"
+};
+
+/****************************************************************************************
+ * Local Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Read the virtual count of the generic timer
+ * @note Without the generic timer (host builds) the nanoseconds are used instead
+ ***************************************************************************************/
+static uint64_t read_ticks(void) {
+#if defined(__aarch64__)
+	uint64_t ticks;
+	__asm__ volatile ("isb\n\tmrs %0, cntvct_el0" : "=r" (ticks) : : "memory");
+	return ticks;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * NS_PER_S + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/****************************************************************************************
+ * Global Functions
+ ***************************************************************************************/
+
+/****************************************************************************************
+ * @brief Take a time stamp from both clocks
+ * @param stamp[out]	Time stamp
+ ***************************************************************************************/
+void TIMING_now(timing_stamp_t *stamp) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	stamp->ticks = read_ticks();
+	stamp->ns = (uint64_t)ts.tv_sec * NS_PER_S + (uint64_t)ts.tv_nsec;
+}
+
+/****************************************************************************************
+ * @brief Frequency of the tick clock
+ * @return Ticks per second
+ ***************************************************************************************/
+uint64_t TIMING_tick_freq(void) {
+#if defined(__aarch64__)
+	uint64_t freq;
+	__asm__ volatile ("mrs %0, cntfrq_el0" : "=r" (freq));
+	return freq;
+#else
+	return NS_PER_S;
+#endif
+}
+
+/****************************************************************************************
+ * @brief Clear all spans of a run
+ * @param run[out]	Run
+ ***************************************************************************************/
+void TIMING_init(timing_run_t *run) {
+	memset(run, 0, sizeof(*run));
+}
+
+/****************************************************************************************
+ * @brief Start a span of a phase
+ * @param run[in,out]	Run
+ * @param phase[in]		Phase
+ ***************************************************************************************/
+void TIMING_begin(timing_run_t *run, timing_phase_t phase) {
+	TIMING_now(&run->begin[phase]);
+}
+
+/****************************************************************************************
+ * @brief Stop the span started with TIMING_begin() and add it to the phase
+ * @param run[in,out]	Run
+ * @param phase[in]		Phase
+ ***************************************************************************************/
+void TIMING_end(timing_run_t *run, timing_phase_t phase) {
+	timing_stamp_t now;
+
+	TIMING_now(&now);
+	run->span[phase].ns += now.ns - run->begin[phase].ns;
+	run->span[phase].ticks += now.ticks - run->begin[phase].ticks;
+	run->recorded |= 1u << phase;
+}
+
+/****************************************************************************************
+ * @brief Print the recorded phases in a human readable table
+ * @param run[in]	Run
+ ***************************************************************************************/
+void TIMING_print(const timing_run_t *run) {
+	uint64_t total_ns = 0;
+
+	for (int p = 0; p < TIMING_PHASES; p++) {
+		if (run->recorded & (1u << p)) {
+			printf("%-10s %10.3f us %10" PRIu64 " ticks\n",
+			       phase_names[p], run->span[p].ns / 1e3, run->span[p].ticks);
+			total_ns += run->span[p].ns;
+		}
+	}
+	printf("%-10s %10.3f us\n", "total", total_ns / 1e3);
+}
+
+/****************************************************************************************
+ * @brief Print the run as one JSON line
+ * @param run[in]		Run
+ * @param engine[in]	Engine name ("apu", "rpu", "fpga", "csu", ...)
+ * @param bytes[in]		Message size
+ * @param ok[in]		Non-zero if the results were correct
+ ***************************************************************************************/
+void TIMING_print_json(const timing_run_t *run, const char *engine, size_t bytes, int ok) {
+	uint64_t total_ns = 0, total_ticks = 0;
+
+	printf("{\"engine\":\"%s\",\"build\":\"%s\",\"bytes\":%zu,\"ok\":%s,\"tick_hz\":%" PRIu64,
+	       engine, BUILD_TYPE, bytes, ok ? "true" : "false", TIMING_tick_freq());
+	for (int p = 0; p < TIMING_PHASES; p++) {
+		if (run->recorded & (1u << p)) {
+			printf(",\"%s_ns\":%" PRIu64 ",\"%s_ticks\":%" PRIu64,
+			       phase_names[p], run->span[p].ns, phase_names[p], run->span[p].ticks);
+			total_ns += run->span[p].ns;
+			total_ticks += run->span[p].ticks;
+		}
+	}
+	printf(",\"total_ns\":%" PRIu64 ",\"total_ticks\":%" PRIu64 "}\n", total_ns, total_ticks);
+}
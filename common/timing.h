@@ -0,0 +1,61 @@
+/****************************************************************************************
+ * @file
+ * @brief See timing.c
+ ***************************************************************************************/
+
+#ifndef TIMING_H
+#define TIMING_H
+
+/****************************************************************************************
+ * Includes
+ ***************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************************
+ * Defines
+ ***************************************************************************************/
+#ifndef BUILD_TYPE
+#define BUILD_TYPE		"unknown"		// build profile, set by the Makefile
+#endif
+
+/****************************************************************************************
+ * Typedefs
+ ***************************************************************************************/
+
+/* Phases of one run, an engine records only the ones it has */
+typedef enum {
+	TIMING_START = 0,		// bring the engine up (firmware, mapping, socket)
+	TIMING_KEY_SETUP,		// load the key, key expansion
+	TIMING_ENCRYPT,
+	TIMING_DECRYPT,
+	TIMING_TEARDOWN,		// clear the key, stop the engine
+	TIMING_PHASES
+} timing_phase_t;
+
+/* Point in time, or the length of a span */
+typedef struct {
+	uint64_t ns;			// CLOCK_MONOTONIC_RAW
+	uint64_t ticks;			// ARM generic timer (cntvct_el0)
+} timing_stamp_t;
+
+typedef struct {
+	timing_stamp_t begin[TIMING_PHASES];
+	timing_stamp_t span[TIMING_PHASES];
+	unsigned recorded;		// bit per phase with a span
+} timing_run_t;
+
+/****************************************************************************************
+ * Functions
+ ***************************************************************************************/
+void TIMING_now(timing_stamp_t *stamp);
+uint64_t TIMING_tick_freq(void);
+
+void TIMING_init(timing_run_t *run);
+void TIMING_begin(timing_run_t *run, timing_phase_t phase);
+void TIMING_end(timing_run_t *run, timing_phase_t phase);
+
+void TIMING_print(const timing_run_t *run);
+void TIMING_print_json(const timing_run_t *run, const char *engine, size_t bytes, int ok);
+
+#endif  /* TIMING_H */